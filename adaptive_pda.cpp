@@ -1,6 +1,7 @@
 #include "adaptive_pda.h"
 #include <iostream>
-#include <stack>
+#include <sstream>
+#include <cctype>
 #include <iomanip>
 
 /**
@@ -22,11 +23,24 @@
  *     * Low (<=0.5): Abort with error
  *   - Allows graceful handling of RNA/DNA transitions or typos
  *
- *   parse():
- *   - Classic LL(1) parsing with stack
+ *   compileTables():
+ *   - Interns "$", the start symbol and every grammar symbol
+ *   - Converts productions and the parsing table to symbol-ID form
+ *
+ *   parse(TokenSource&):
+ *   - Classic LL(1) parsing with an integer stack
  *   - For terminals: match with lookahead or use adaptive repair
  *   - For non-terminals: push production RHS in reverse order
- *   - Terminates when stack reaches $ and lookahead is $
+ *   - Terminates when stack reaches $ and lookahead is $ (END_OF_INPUT)
+ *   - Writes the step trace only when a trace stream is supplied
+ *
+ *   parse(vector<string>):
+ *   - Interns the tokens and parses them through a SpanTokenSource,
+ *     returning the full trace as before
+ *
+ *   parseAll():
+ *   - One ByteTokenSource per input over the cached byte map; with dedup
+ *     only the first occurrence of each distinct input is parsed
  */
 
 AdaptivePDA::AdaptivePDA() {
@@ -56,101 +70,193 @@ AdaptivePDA::AdaptivePDA() {
    
     // Purine-Purine clashing (A cannot replace C)
     affinityMatrix["C"]["A"] = 0.05;
+
+    compileTables();
+}
+
+void AdaptivePDA::compileTables() {
+    symbolId("$");
+    startId = symbolId(startSymbol);
+
+    ruleRhs.clear();
+    for (const auto& p : grammar) {
+        symbolId(p.lhs);
+        std::vector<int> rhs;
+        for (const auto& sym : p.rhs) rhs.push_back(symbolId(sym));
+        ruleRhs.push_back(rhs);
+    }
+
+    tableIds.assign(symbolNames.size(), {});
+    for (const auto& [nonTerminal, row] : parsingTable) {
+        std::vector<int>& ids = tableIds[symbolId(nonTerminal)];
+        for (const auto& [lookahead, rule] : row) {
+            int la = symbolId(lookahead);
+            if (la >= static_cast<int>(ids.size())) ids.resize(la + 1, -1);
+            ids[la] = rule;
+        }
+    }
+}
+
+int AdaptivePDA::symbolId(const std::string& name) {
+    auto it = symbolIds.find(name);
+    if (it != symbolIds.end()) return it->second;
+
+    int id = static_cast<int>(symbolNames.size());
+    symbolIds[name] = id;
+    symbolNames.push_back(name);
+    adaptiveIds.push_back(-1);
+    return id;
+}
+
+const std::string& AdaptivePDA::symbolName(int id) const {
+    static const std::string unknown = "<unknown>";
+    if (id < 0 || id >= static_cast<int>(symbolNames.size())) return unknown;
+    return symbolNames[id];
+}
+
+ByteTokenMap AdaptivePDA::byteTokenMap() {
+    ByteTokenMap map;
+    for (int b = 0; b < 256; b++) {
+        map[b] = isspace(b) ? TokenSource::SKIP : symbolId(std::string(1, static_cast<char>(b)));
+    }
+    return map;
+}
+
+bool AdaptivePDA::isNonTerminal(int id) const {
+    return id >= 0 && id < static_cast<int>(tableIds.size()) && !tableIds[id].empty();
+}
+
+double AdaptivePDA::affinity(int required, int actual) const {
+    auto row = affinityMatrix.find(symbolName(required));
+    if (row == affinityMatrix.end()) return 0.0;
+    auto cell = row->second.find(symbolName(actual));
+    return (cell == row->second.end()) ? 0.0 : cell->second;
 }
 
 void AdaptivePDA::adaptiveRepair(std::string requiredToken, std::string actualToken) {
     // Adaptive repair now doesn't print; called from parse() which captures everything
-    double affinity = 0.0;
-    if (affinityMatrix.count(requiredToken) && affinityMatrix[requiredToken].count(actualToken)) {
-        affinity = affinityMatrix[requiredToken][actualToken];
-    }
+    int required = symbolId(requiredToken);
+    int actual = symbolId(actualToken);
+    double score = affinity(required, actual);
 
-    if (affinity > 0.8) {
-        adaptiveMap[actualToken] = requiredToken;
+    if (score > 0.8) {
+        adaptiveIds[actual] = required;
     }
-    else if (affinity > 0.5) {
-        adaptiveMap[actualToken] = requiredToken;
+    else if (score > 0.5) {
+        adaptiveIds[actual] = required;
     }
     else {
         // Low affinity: still update map but user sees warning in parse output
-        adaptiveMap[actualToken] = requiredToken;
+        adaptiveIds[actual] = required;
     }
 }
 
-std::string AdaptivePDA::parse(std::vector<std::string> tokens) {
-    std::ostringstream ss;
-    std::stack<std::string> s;
-    s.push("$");
-    s.push(startSymbol);
-   
-    int ptr = 0;
-    tokens.push_back("$");
+bool AdaptivePDA::parse(TokenSource& source, std::ostream* trace) {
+    std::vector<int>& stack = parseStack;
+    stack.clear();
+    stack.push_back(END_SYMBOL);
+    stack.push_back(startId);
 
-    ss << "\n--- DNA Hairpin Parser (Adaptive) ---\n";
+    const int symbolCount = static_cast<int>(symbolNames.size());
 
-    while (!s.empty()) {
-        std::string top = s.top();
-        std::string lookahead = tokens[ptr];
-       
-        if (top == "$") {
-            if (lookahead == "$") {
-                ss << "STRUCTURE STABLE\n";
-                return ss.str();
+    while (!stack.empty()) {
+        int top = stack.back();
+        int lookahead = source.peek();
+        if (lookahead == TokenSource::END_OF_INPUT) lookahead = END_SYMBOL;
+
+        if (top == END_SYMBOL) {
+            if (lookahead == END_SYMBOL) {
+                if (trace) *trace << "STRUCTURE STABLE\n";
+                return true;
             }
         }
 
         // Case 1: Stack Top is Terminal
-        if (parsingTable.find(top) == parsingTable.end()) {
-           
+        if (!isNonTerminal(top)) {
+
             if (top == lookahead) {
-                ss << "Match " << top << "\n";
-                s.pop(); ptr++;
+                if (trace) *trace << "Match " << symbolName(top) << "\n";
+                stack.pop_back(); source.advance();
             }
-            else if (adaptiveMap.count(lookahead) && adaptiveMap[lookahead] == top) {
-                 ss << "Match " << top << " (via " << lookahead << ")\n";
-                 s.pop(); ptr++;
+            else if (lookahead >= 0 && lookahead < symbolCount && adaptiveIds[lookahead] == top) {
+                if (trace) *trace << "Match " << symbolName(top) << " (via " << symbolName(lookahead) << ")\n";
+                stack.pop_back(); source.advance();
             }
             else {
-                double affinity = 0.0;
-                if (affinityMatrix.count(top) && affinityMatrix[top].count(lookahead)) {
-                    affinity = affinityMatrix[top][lookahead];
+                double score = affinity(top, lookahead);
+                if (trace) {
+                    *trace << "[!] Mismatch: Expected [" << symbolName(top) << "], Found ["
+                           << symbolName(lookahead) << "]\n";
+                    *trace << "[*] Affinity: " << score << " / 1.0\n";
                 }
-                ss << "[!] Mismatch: Expected [" << top << "], Found [" << lookahead << "]\n";
-                ss << "[*] Affinity: " << affinity << " / 1.0\n";
-                
-                if (affinity > 0.8) {
-                    ss << "[+] HIGH: Accepting substitution.\n";
-                    adaptiveMap[lookahead] = top;
-                } else if (affinity > 0.5) {
-                    ss << "[~] MEDIUM: Wobble pairing; continuing.\n";
-                    adaptiveMap[lookahead] = top;
+
+                if (score > 0.8) {
+                    if (trace) *trace << "[+] HIGH: Accepting substitution.\n";
+                    adaptiveIds[lookahead] = top;
+                } else if (score > 0.5) {
+                    if (trace) *trace << "[~] MEDIUM: Wobble pairing; continuing.\n";
+                    adaptiveIds[lookahead] = top;
                 } else {
-                    ss << "[-] LOW: Rejecting. Parse failed.\n";
-                    return ss.str();
+                    if (trace) *trace << "[-] LOW: Rejecting. Parse failed.\n";
+                    return false;
                 }
             }
         }
         // Case 2: Stack Top is Non-Terminal
-        else if (parsingTable.count(top)) {
-            if (parsingTable[top].find(lookahead) == parsingTable[top].end()) {
-                ss << "ERROR: Invalid start of structure.\n";
-                return ss.str();
+        else {
+            const std::vector<int>& row = tableIds[top];
+            if (lookahead < 0 || lookahead >= static_cast<int>(row.size()) || row[lookahead] < 0) {
+                if (trace) *trace << "ERROR: Invalid start of structure.\n";
+                return false;
             }
 
-            int ruleIndex = parsingTable[top][lookahead];
-            Production p = grammar[ruleIndex];
-           
-            std::string rhsStr = "";
-            for(const auto& val : p.rhs) rhsStr += val + " ";
-            ss << "Expand " << p.lhs << " -> " << rhsStr << "\n";
-           
-            s.pop();
-            for (int i = p.rhs.size() - 1; i >= 0; i--) s.push(p.rhs[i]);
-        }
-        else {
-            ss << "Error: Unknown state.\n";
-            return ss.str();
+            int ruleIndex = row[lookahead];
+            const std::vector<int>& rhs = ruleRhs[ruleIndex];
+
+            if (trace) {
+                const Production& p = grammar[ruleIndex];
+                std::string rhsStr = "";
+                for(const auto& val : p.rhs) rhsStr += val + " ";
+                *trace << "Expand " << p.lhs << " -> " << rhsStr << "\n";
+            }
+
+            stack.pop_back();
+            for (int i = rhs.size() - 1; i >= 0; i--) stack.push_back(rhs[i]);
         }
     }
+    return false;
+}
+
+std::string AdaptivePDA::parse(std::vector<std::string> tokens) {
+    std::ostringstream ss;
+    std::vector<int> ids;
+    ids.reserve(tokens.size());
+    for (const auto& token : tokens) ids.push_back(symbolId(token));
+
+    ss << "\n--- DNA Hairpin Parser (Adaptive) ---\n";
+
+    SpanTokenSource source(ids);
+    parse(source, &ss);
     return ss.str();
 }
+
+void AdaptivePDA::parseAll(const std::vector<std::string>& inputs, std::vector<char>& results, bool dedup) {
+    if (!batchMapReady) {
+        batchMap = byteTokenMap();
+        batchMapReady = true;
+    }
+    auto parseOne = [&](const std::string& input) -> char {
+        ByteTokenSource source(input.data(), input.size(), batchMap);
+        return parse(source);
+    };
+
+    if (!dedup) {
+        results.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) results[i] = parseOne(inputs[i]);
+        return;
+    }
+    unique.build(inputs);
+    distinctResults.resize(unique.distinctCount());
+    for (size_t k = 0; k < unique.distinctCount(); k++) distinctResults[k] = parseOne(inputs[unique.distinct()[k]]);
+    unique.scatter(distinctResults, results);
+}
@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <iosfwd>
+#include "token_source.h"
+#include "batch_dedup.h"
 
 /**
  * FILE: adaptive_pda.h
@@ -37,7 +41,31 @@
  *   5. Parse Function
  *      - Standard stack-based LL(1) parser
  *      - Uses adaptive repair instead of hard failure
- *      - Learns token equivalences in adaptiveMap
+ *      - Learns token equivalences in the adaptive map (adaptiveIds)
+ *
+ *   6. Symbol Interning
+ *      - Every grammar symbol and token name gets a dense integer ID
+ *        ("$" is always END_SYMBOL = 0)
+ *      - The string tables above are compiled into ID-indexed tables, so the
+ *        parser loop compares integers instead of strings
+ *
+ *   7. Token Source Parse Function
+ *      - parse(TokenSource&) pulls lookahead IDs via peek/advance
+ *        (see token_source.h); sources can be spans, mapped files, streams,
+ *        or a generated lexer
+ *      - Memory is O(stack depth); trace output is optional
+ *      - The parse stack is a member reused across calls, so once it has
+ *        grown to the deepest nesting seen, parsing without a trace performs
+ *        no heap allocation
+ *
+ *   8. Batch Parse Function
+ *      - parseAll(inputs, results[, dedup]) parses every string one token
+ *        per byte (byteTokenMap(), whitespace skipped)
+ *      - With dedup, each distinct string is parsed once (batch_dedup.h)
+ *        and its verdict copied to the duplicates. parse() only learns
+ *        substitutions it would accept anyway, so this is the same as
+ *        parsing every copy, unless adaptiveRepair() has forced a
+ *        low-affinity substitution that a later parse overwrites
  */
 
 struct Production {
@@ -49,13 +77,37 @@ class AdaptivePDA {
     std::map<std::string, std::map<std::string, int>> parsingTable;
     std::vector<Production> grammar;
     std::string startSymbol;
-    std::map<std::string, std::string> adaptiveMap;
     std::map<std::string, std::map<std::string, double>> affinityMatrix;
 
+    // Interned tables used by the parser loop
+    std::vector<std::string> symbolNames;
+    std::unordered_map<std::string, int> symbolIds;
+    std::vector<std::vector<int>> ruleRhs;    // Production RHS as symbol IDs
+    std::vector<std::vector<int>> tableIds;   // [non-terminal][lookahead] -> rule, -1 = none
+    std::vector<int> adaptiveIds;             // Lookahead symbol -> terminal it stands in for
+    std::vector<int> parseStack;              // Reused by parse(TokenSource&)
+    ByteTokenMap batchMap{};                  // parseAll(): byteTokenMap(), built on first use
+    bool batchMapReady = false;
+    BatchDedup unique;                        // parseAll(..., dedup) scratch
+    std::vector<char> distinctResults;
+    int startId;
+
+    void compileTables();
+    bool isNonTerminal(int id) const;
+    double affinity(int required, int actual) const;
+
 public:
+    static constexpr int END_SYMBOL = 0;
+
     AdaptivePDA();
     void adaptiveRepair(std::string requiredToken, std::string actualToken);
     std::string parse(std::vector<std::string> tokens);
+    bool parse(TokenSource& source, std::ostream* trace = nullptr);
+    void parseAll(const std::vector<std::string>& inputs, std::vector<char>& results, bool dedup = false);
+
+    int symbolId(const std::string& name);
+    const std::string& symbolName(int id) const;
+    ByteTokenMap byteTokenMap();
 };
 
 #endif
@@ -0,0 +1,118 @@
+#include "batch_dedup.h"
+#include <cstring>
+
+/**
+ * FILE: batch_dedup.cpp
+ * DESCRIPTION: XXH64 and the deduplicating hash table
+ * PROCESS:
+ *
+ *   hashBytes():
+ *   - The XXH64 reference algorithm; words are read with memcpy (no
+ *     alignment requirement) in host byte order, which is enough for a
+ *     hash that never leaves the process
+ *
+ *   build():
+ *   - The table is sized to a power of two >= 2 * inputs, so probes stay
+ *     short and slot = hash & mask
+ *   - A probe stops at a free slot (new distinct value) or at a slot with
+ *     the same hash and the same bytes (duplicate)
+ */
+
+namespace {
+
+const uint64_t PRIME1 = 11400714785074694791ULL;
+const uint64_t PRIME2 = 14029467366897019727ULL;
+const uint64_t PRIME3 = 1609587929392839161ULL;
+const uint64_t PRIME4 = 9650029242287828579ULL;
+const uint64_t PRIME5 = 2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t laneRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    return rotl(acc, 31) * PRIME1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= laneRound(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+}  // namespace
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2, v2 = seed + PRIME2, v3 = seed, v4 = seed - PRIME1;
+        for (; end - p >= 32; p += 32) {
+            v1 = laneRound(v1, read64(p));
+            v2 = laneRound(v2, read64(p + 8));
+            v3 = laneRound(v3, read64(p + 16));
+            v4 = laneRound(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+    h += size;
+
+    for (; end - p >= 8; p += 8) h = rotl(h ^ laneRound(0, read64(p)), 27) * PRIME1 + PRIME4;
+    if (end - p >= 4) {
+        h = rotl(h ^ (read32(p) * PRIME1), 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; p++) h = rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+void BatchDedup::build(const std::vector<std::string>& inputs) {
+    size_t capacity = 16;
+    while (capacity < inputs.size() * 2) capacity <<= 1;
+    slots.assign(capacity, Slot{0, EMPTY});
+    firsts.clear();
+    slotOfInput.resize(inputs.size());
+    size_t mask = capacity - 1;
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const std::string& input = inputs[i];
+        uint64_t hash = hashBytes(input.data(), input.size());
+        for (size_t at = hash & mask;; at = (at + 1) & mask) {
+            Slot& slot = slots[at];
+            if (slot.distinct == EMPTY) {
+                slot = {hash, static_cast<uint32_t>(firsts.size())};
+                firsts.push_back(static_cast<uint32_t>(i));
+            } else if (slot.hash != hash || inputs[firsts[slot.distinct]] != input) {
+                continue;
+            }
+            slotOfInput[i] = slot.distinct;
+            break;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef BATCH_DEDUP_H
+#define BATCH_DEDUP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * FILE: batch_dedup.h
+ * DESCRIPTION: Duplicate detection for batch APIs, so each distinct input is computed once
+ * PROCESS:
+ *
+ *   Reads, log lines and token streams repeat. A batch call that matches or
+ *   parses every element recomputes the same answer for every copy. The
+ *   batch APIs (PatternMatcher::matchAll, AdaptivePDA::parseAll) can route
+ *   their inputs through BatchDedup first:
+ *
+ *   1. hashBytes(): 64-bit xxHash (XXH64) of a byte string
+ *      - Four 8-byte lanes over 32-byte stripes, then the tail and a final
+ *        avalanche; several GB/s, so hashing costs far less than matching
+ *      - Non-cryptographic: only used to find candidates, never trusted alone
+ *
+ *   2. BatchDedup::build(inputs)
+ *      - Open-addressing table (linear probing, at least twice as many
+ *        slots as inputs) of (hash, distinct index)
+ *      - Equal hashes are confirmed by comparing the bytes, so a collision
+ *        can cost time but never a wrong answer
+ *      - distinct(): index of the first occurrence of every distinct value,
+ *        in input order; slotOf(i): which distinct value input i is
+ *      - Buffers are reused across builds: steady-state batches of similar
+ *        size do not allocate
+ *
+ *   3. scatter(distinctResults, results): results[i] = distinctResults[slotOf(i)]
+ *
+ *   Batches are limited to 2^32 - 1 inputs (32-bit indices).
+ */
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+class BatchDedup {
+    struct Slot {
+        uint64_t hash;
+        uint32_t distinct;  // EMPTY = free
+    };
+
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> firsts;
+    std::vector<uint32_t> slotOfInput;
+
+public:
+    void build(const std::vector<std::string>& inputs);
+
+    size_t distinctCount() const { return firsts.size(); }
+    const std::vector<uint32_t>& distinct() const { return firsts; }
+    uint32_t slotOf(size_t input) const { return slotOfInput[input]; }
+
+    template <typename Result>
+    void scatter(const std::vector<Result>& distinctResults, std::vector<Result>& results) const {
+        results.resize(slotOfInput.size());
+        for (size_t i = 0; i < slotOfInput.size(); i++) results[i] = distinctResults[slotOfInput[i]];
+    }
+};
+
+#endif
@@ -0,0 +1,274 @@
+/**
+ * FILE: bench/benchmark.cpp
+ * DESCRIPTION: Throughput benchmark for the matching engines and the lexer
+ * PROCESS:
+ *
+ *   For each pattern:
+ *   1. Compile once (NFA, counting-set NFA, DFA, minimized DFA, and the
+ *      minimized DFA in the premultiplied layout; small automata run on the
+ *      Sheng engine and are also timed on the table alone, and on the
+ *      row-compressed table and the native code where the JIT is available;
+ *      PatternMatcher runs its own pick, behind its prefilter)
+ *   2. StringGenerator builds a corpus: half accepted strings, half near-miss
+ *      rejects, so neither the accept nor the reject path is favoured
+ *   3. Every engine runs over the corpus; the best of several repetitions is
+ *      reported as ns per string and MB/s, plus heap allocations per string
+ *      counted in the last repetition (allocation_counter.h), i.e. in the
+ *      steady state once any reusable buffers have grown
+ *   4. Latency of a one-off query: compiling the pattern (NFA, DFA,
+ *      minimization, layout) and matching one string, against the lazy
+ *      derivative matcher that only builds the states that string visits
+ *
+ *   Then the multi-rule lexer tokenizes a generated source text, and batch
+ *   matching and parsing run over redundant batches (each distinct input
+ *   about 20 times), with and without deduplication (batch_dedup.h).
+ *
+ *   usage: atfl_benchmark [strings per pattern]
+ */
+
+#include "regex_preprocessor.h"
+#include "thompsons_construction.h"
+#include "nfa_simulator.h"
+#include "counting_set_automaton.h"
+#include "dfa_construction.h"
+#include "dfa_operations.h"
+#include "compiled_dfa.h"
+#include "dfa_jit.h"
+#include "derivative_matcher.h"
+#include "match_planner.h"
+#include "string_generator.h"
+#include "lexer_generator.h"
+#include "adaptive_pda.h"
+#include "allocation_counter.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+struct BenchPattern {
+    std::string name;
+    std::string regex;
+    int length;       // Length of generated strings
+    bool slowEngines; // Also time the NFA simulators
+};
+
+struct Measurement {
+    double seconds;      // Best wall time of one pass
+    size_t allocations;  // Heap allocations during the last pass
+};
+
+static volatile size_t sink;
+
+// Best-of-N wall time of one pass over the corpus, in seconds
+static Measurement timeBest(const std::function<size_t()>& pass, int repetitions = 5) {
+    Measurement m = {1e30, 0};
+    for (int r = 0; r < repetitions; r++) {
+        AllocationScope scope;
+        auto start = std::chrono::steady_clock::now();
+        sink = pass();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < m.seconds) m.seconds = elapsed.count();
+        m.allocations = scope.count();
+    }
+    return m;
+}
+
+static void report(const std::string& engine, const Measurement& m, size_t items, size_t bytes,
+                   const char* unit = "string") {
+    std::cout << "  " << std::left << std::setw(16) << engine << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << m.seconds * 1e9 / items << " ns/" << unit
+              << std::setw(10) << bytes / m.seconds / 1e6 << " MB/s"
+              << std::setprecision(2) << std::setw(10) << static_cast<double>(m.allocations) / items
+              << " allocs/" << unit << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::vector<BenchPattern> patterns = {
+        {"identifier", "[a-zA-Z][a-zA-Z0-9]*", 16, true},
+        {"dna-read", "[ACGT]{50,500}", 150, false},
+        {"dna-motif", "[ACGT]*TATA[AT]A[AT][ACGT]*", 64, true},
+        {"log-line", "[0-9]{4}-[0-9]{2}-[0-9]{2} (INFO|WARN|ERROR) [a-z]+: .*", 60, false},
+        {"log-search", ".*(ERROR|WARN).*", 200, false},
+    };
+
+    for (const auto& pattern : patterns) {
+        NFAFragment nfa = regexToNFA(toPostfix(preprocessRegex(pattern.regex)));
+        CountingNFA counting = buildCountingNFA(nfa);
+        DFA dfa = buildDFA(nfa);
+        DFA minimal = minimizeDFA(dfa);
+        CompiledDFA compiled = compileDFA(minimal);
+        CompiledDFA packed = compileDFA(minimal, 0);
+        packed.sheng = ShengDFA();
+
+        StringGenerator generator(minimal, pattern.length);
+        std::vector<std::string> corpus;
+        size_t bytes = 0;
+        std::string s;
+        for (size_t n = 0; n < count; n++) {
+            bool ok = (n % 2 == 0) ? generator.sample(pattern.length, s) : generator.nearMiss(pattern.length, s);
+            if (!ok) continue;
+            bytes += s.size();
+            corpus.push_back(s);
+        }
+
+        std::cout << pattern.name << " " << pattern.regex << " (" << corpus.size() << " strings, DFA "
+                  << dfa.stateCount() << " -> " << minimal.stateCount() << " states, compiled "
+                  << compiled.memoryBytes() << " B with " << compiled.idBytes << "-byte IDs, row-compressed "
+                  << packed.memoryBytes() << " B)" << std::endl;
+
+        report("dfa", timeBest([&] {
+            size_t hits = 0;
+            for (const auto& str : corpus) hits += dfa.matches(str);
+            return hits;
+        }), corpus.size(), bytes);
+
+        report("minimized-dfa", timeBest([&] {
+            size_t hits = 0;
+            for (const auto& str : corpus) hits += minimal.matches(str);
+            return hits;
+        }), corpus.size(), bytes);
+
+        report(compiled.sheng.empty() ? "compiled-dfa" : "sheng-dfa", timeBest([&] {
+            size_t hits = 0;
+            for (const auto& str : corpus) hits += compiled.matches(str);
+            return hits;
+        }), corpus.size(), bytes);
+
+        if (!compiled.sheng.empty()) {
+            CompiledDFA table = compiled;
+            table.sheng = ShengDFA();
+            report("table-dfa", timeBest([&] {
+                size_t hits = 0;
+                for (const auto& str : corpus) hits += table.matches(str);
+                return hits;
+            }), corpus.size(), bytes);
+        }
+
+        report("row-compressed", timeBest([&] {
+            size_t hits = 0;
+            for (const auto& str : corpus) hits += packed.matches(str);
+            return hits;
+        }), corpus.size(), bytes);
+
+        DFAJit jit;
+        if (jit.compile(compiled)) {
+            report("jit", timeBest([&] {
+                size_t hits = 0;
+                for (const auto& str : corpus) hits += jit.matches(str.data(), str.size());
+                return hits;
+            }), corpus.size(), bytes);
+        }
+
+        PatternMatcher planned(pattern.regex);
+        std::vector<char> results;
+        report("planner", timeBest([&] {
+            planned.matchAll(corpus, results);
+            return results.size();
+        }), corpus.size(), bytes);
+
+        // The set-based simulators are orders of magnitude slower: time a slice
+        size_t slice = std::min<size_t>(corpus.size(), 2000);
+        std::vector<std::string> sample(corpus.begin(), corpus.begin() + slice);
+        size_t sampleBytes = 0;
+        for (const auto& str : sample) sampleBytes += str.size();
+
+        report("counting-set", timeBest([&] {
+            size_t hits = 0;
+            for (const auto& str : sample) hits += simulateCountingNFA(counting, str);
+            return hits;
+        }, 2), sample.size(), sampleBytes);
+
+        if (pattern.slowEngines) {
+            report("nfa", timeBest([&] {
+                size_t hits = 0;
+                for (const auto& str : sample) hits += simulateNFA(nfa, str);
+                return hits;
+            }, 2), sample.size(), sampleBytes);
+        }
+
+        // One-off query: compile the pattern and match a single string
+        const std::string postfix = toPostfix(preprocessRegex(pattern.regex));
+        const std::string& query = corpus.front();
+        report("compile+dfa", timeBest([&] {
+            return compileDFA(minimizeDFA(buildDFA(regexToNFA(postfix)))).matches(query);
+        }), 1, query.size(), "query");
+        report("compile+deriv", timeBest([&] {
+            return DerivativeMatcher(postfix).matches(query);
+        }), 1, query.size(), "query");
+
+        StateManager::clear();
+    }
+
+    // Lexer over a generated token stream
+    Lexer lexer({{"KEYWORD", "if|while|for|return"}, {"IDENT", "[a-zA-Z][a-zA-Z0-9]*"},
+                 {"NUMBER", "[0-9]+"}, {"SPACE", " +", true}});
+    StringGenerator words(buildDFA(regexToNFA(toPostfix(preprocessRegex("[a-zA-Z][a-zA-Z0-9]*|[0-9]+")))), 12);
+    std::string source, word;
+    while (source.size() < count * 10) {
+        words.sample(1 + source.size() % 12, word);
+        source += word;
+        source += ' ';
+    }
+    StateManager::clear();
+
+    std::vector<Token> tokens;
+    tokens.reserve(source.size() / 2);
+    Measurement tokenize = timeBest([&] {
+        tokens.clear();
+        return lexer.tokenize(source, tokens);
+    });
+    std::cout << "lexer (" << tokens.size() << " tokens, " << source.size() << " bytes)" << std::endl;
+    report("tokenize", tokenize, tokens.size(), source.size(), "token");
+
+    // Redundant batches: every distinct read or hairpin occurs about 20 times
+    StringGenerator reads(minimizeDFA(buildDFA(regexToNFA(toPostfix(preprocessRegex("[ACGT]{150}"))))), 150);
+    std::vector<std::string> distinctReads(count / 20 + 1), distinctHairpins;
+    for (auto& read : distinctReads) {
+        reads.sample(150, read);
+        // Stem of A/G from the read, its complement mirrored on the other side
+        std::string stem, hairpin;
+        for (size_t k = 0; k < 40; k++) stem += (read[k] == 'A' || read[k] == 'T') ? 'A' : 'G';
+        hairpin = stem + '.';
+        for (size_t k = stem.size(); k-- > 0;) hairpin += (stem[k] == 'A') ? 'T' : 'C';
+        distinctHairpins.push_back(hairpin);
+    }
+    StateManager::clear();
+
+    std::vector<std::string> readBatch, hairpinBatch;
+    size_t readBytes = 0, hairpinBytes = 0;
+    for (size_t n = 0; n < count; n++) {
+        size_t pick = (n * 7919) % distinctReads.size();
+        readBatch.push_back(distinctReads[pick]);
+        hairpinBatch.push_back(distinctHairpins[pick]);
+        readBytes += readBatch.back().size();
+        hairpinBytes += hairpinBatch.back().size();
+    }
+
+    PatternMatcher motif("[ACGT]*TATA[AT]A[AT][ACGT]*", MatchWorkload::BATCH);
+    PatternMatcher wide("[ACGT]*A[ACGT]{20}");
+    AdaptivePDA parser;
+    std::vector<char> results;
+    std::cout << "redundant batches (" << readBatch.size() << " inputs, " << distinctReads.size()
+              << " distinct; " << wide.plan().describe() << ")" << std::endl;
+    for (int dedup = 0; dedup < 2; dedup++) {
+        const char* suffix = dedup ? "+dedup" : "";
+        report(std::string("sheng") + suffix, timeBest([&] {
+            motif.matchAll(readBatch, results, dedup);
+            return results.size();
+        }), readBatch.size(), readBytes);
+        report(std::string("counting") + suffix, timeBest([&] {
+            wide.matchAll(readBatch, results, dedup);
+            return results.size();
+        }, 1), readBatch.size(), readBytes);
+        report(std::string("parse") + suffix, timeBest([&] {
+            parser.parseAll(hairpinBatch, results, dedup);
+            return results.size();
+        }), hairpinBatch.size(), hairpinBytes);
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * FILE: cli/atfl_cli.cpp
+ * DESCRIPTION: Command-line front end to the automata library
+ * PROCESS:
+ *
+ *   atfl match [-c] [--utf8] [--explain] <regex> [file...]
+ *       Print the lines (or with -c the number of lines) that the regex
+ *       matches in full. Reads stdin when no file is given. The pattern is
+ *       compiled once for a batch workload (match_planner.h): usually a
+ *       minimized DFA in the premultiplied layout (compiled_dfa.h), one
+ *       table lookup per byte, running as native code after
+ *       HotDFA::JIT_THRESHOLD lines (dfa_jit.h); a counting-set or NFA
+ *       simulation when the DFA would be too large. --explain prints the
+ *       chosen engine and why to stderr.
+ *
+ *   atfl equiv <regex> <regex>
+ *       Language equivalence; prints a shortest counterexample otherwise.
+ *       Exit status 0 = equivalent, 1 = different.
+ *
+ *   atfl generate [--reject] <regex> <length> <count>
+ *       Uniformly random accepted strings (or near-miss rejects).
+ *
+ *   Exit status 2 = usage error or malformed pattern.
+ */
+
+#include "regex_preprocessor.h"
+#include "thompsons_construction.h"
+#include "dfa_construction.h"
+#include "dfa_operations.h"
+#include "match_planner.h"
+#include "string_generator.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <memory>
+
+static const size_t DFA_STATE_LIMIT = 1 << 20;
+
+static int usage() {
+    std::cerr << "usage: atfl match [-c] [--utf8] [--explain] <regex> [file...]\n"
+              << "       atfl equiv <regex> <regex>\n"
+              << "       atfl generate [--reject] <regex> <length> <count>\n";
+    return 2;
+}
+
+static bool compile(const std::string& regex, bool utf8, DFA& dfa) {
+    std::string postfix = toPostfix(preprocessRegex(regex));
+    if (!isValidPostfix(postfix)) {
+        std::cerr << "atfl: malformed regex '" << regex << "'" << std::endl;
+        return false;
+    }
+    try {
+        dfa = buildDFA(regexToNFA(postfix, utf8), DFA_STATE_LIMIT);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "atfl: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Matches every line of text; prints matching lines unless countOnly
+static size_t matchLines(PatternMatcher& matcher, const std::string& text, bool countOnly, std::ostream& out) {
+    size_t matched = 0;
+    const char* data = text.data();
+    const char* end = data + text.size();
+    while (data < end) {
+        const char* newline = static_cast<const char*>(memchr(data, '\n', end - data));
+        const char* lineEnd = newline ? newline : end;
+        size_t length = lineEnd - data;
+        if (length > 0 && lineEnd[-1] == '\r') length--;
+
+        if (matcher.matches(data, length)) {
+            matched++;
+            if (!countOnly) out.write(data, length).put('\n');
+        }
+        data = newline ? newline + 1 : end;
+    }
+    return matched;
+}
+
+static int runMatch(int argc, char* argv[]) {
+    bool countOnly = false, utf8 = false, explain = false;
+    int i = 0;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (std::strcmp(argv[i], "-c") == 0) countOnly = true;
+        else if (std::strcmp(argv[i], "--utf8") == 0) utf8 = true;
+        else if (std::strcmp(argv[i], "--explain") == 0) explain = true;
+        else return usage();
+    }
+    if (i >= argc) return usage();
+
+    std::unique_ptr<PatternMatcher> matcher;
+    try {
+        matcher.reset(new PatternMatcher(argv[i++], MatchWorkload::BATCH, utf8));
+    } catch (const std::runtime_error& e) {
+        std::cerr << "atfl: " << e.what() << std::endl;
+        return 2;
+    }
+    if (explain) std::cerr << "atfl: " << matcher->plan().describe() << std::endl;
+
+    size_t matched = 0;
+    if (i >= argc) {
+        std::ostringstream buffer;
+        buffer << std::cin.rdbuf();
+        matched = matchLines(*matcher, buffer.str(), countOnly, std::cout);
+    }
+    for (; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::cerr << "atfl: cannot open " << argv[i] << std::endl;
+            return 2;
+        }
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        matched += matchLines(*matcher, buffer.str(), countOnly, std::cout);
+    }
+
+    if (countOnly) std::cout << matched << std::endl;
+    return matched > 0 ? 0 : 1;
+}
+
+static int runEquiv(int argc, char* argv[]) {
+    if (argc != 2) return usage();
+    DFA first, second;
+    if (!compile(argv[0], false, first) || !compile(argv[1], false, second)) return 2;
+
+    LanguageCheck check = checkEquivalence(first, second);
+    if (check.holds) {
+        std::cout << "equivalent" << std::endl;
+        return 0;
+    }
+    std::cout << "different: \"" << check.counterexample << "\" is accepted by "
+              << (first.matches(check.counterexample) ? "the first" : "the second") << " only" << std::endl;
+    return 1;
+}
+
+static int runGenerate(int argc, char* argv[]) {
+    bool reject = (argc > 0 && std::strcmp(argv[0], "--reject") == 0);
+    if (reject) { argc--; argv++; }
+    if (argc != 3) return usage();
+
+    DFA dfa;
+    if (!compile(argv[0], false, dfa)) return 2;
+    int length = std::atoi(argv[1]);
+    long count = std::atol(argv[2]);
+    if (length < 0 || count < 0) return usage();
+
+    StringGenerator generator(dfa, length);
+    std::string s;
+    for (long n = 0; n < count; n++) {
+        bool ok = reject ? generator.nearMiss(length, s) : generator.sample(length, s);
+        if (!ok) {
+            std::cerr << "atfl: no " << (reject ? "near-miss rejects" : "accepted strings")
+                      << " of length " << length << std::endl;
+            return 1;
+        }
+        std::cout << s << '\n';
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) return usage();
+    std::string command = argv[1];
+    if (command == "match") return runMatch(argc - 2, argv + 2);
+    if (command == "equiv") return runEquiv(argc - 2, argv + 2);
+    if (command == "generate") return runGenerate(argc - 2, argv + 2);
+    return usage();
+}
@@ -0,0 +1,396 @@
+#include "compiled_dfa.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COMPILED_DFA_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * FILE: compiled_dfa.cpp
+ * DESCRIPTION: Conversion from the construction DFA to the premultiplied layout
+ * PROCESS:
+ *
+ *   compileDFA():
+ *   - Byte classes: bytes b1, b2 share a class when every state sends them
+ *     to the same target; classes are found by keying each byte's column
+ *     (its target in every state) in a map, numbered in byte order
+ *   - findAccel(): escape bytes = bytes that leave the state; at most 3
+ *     makes an ESCAPE_BYTES state, otherwise the self-loop bytes are split
+ *     into ranges and at most 4 ranges covering MIN_STAY_BYTES or more
+ *     make a STAY_RANGES state
+ *   - Row order: dead row, accelerated states, accepting states, the rest
+ *     (stable within each group)
+ *   - Every DFA::DEAD_STATE entry becomes ID 0; every other target becomes
+ *     its row number << strideShift
+ *   - Width: 1 byte when the largest ID is below 255, 2 below 65535, else 4
+ *     (the all-ones value is kept free as DFATables::EMPTY)
+ *   - packRows(), only when the dense table exceeds denseBudget: each row's
+ *     default is its most frequent target; rows are placed in the comb by
+ *     first fit, most exceptions first, starting at the first free slot
+ *   - Without accelerated states, buildSheng() is tried last; it leaves the
+ *     ShengDFA empty when the automaton has more than 15 states
+ *   - Time: O(256 * |states| * log 256) for the classes, O(|states| * stride)
+ *     for the table
+ *
+ *   matches() / longestMatch() / next():
+ *   - withStep() picks DenseStep or CombStep for the stored width once and
+ *     passes it to the loop template, so each (width, layout) pair gets its
+ *     own loop with the step inlined
+ *
+ *   accelScan():
+ *   - ESCAPE_BYTES: memchr for one byte; for two or three, 16 bytes are
+ *     compared against each escape byte at once and the first set bit of
+ *     the OR-ed movemask is the answer
+ *   - STAY_RANGES: a byte b is in [lo, hi] iff (b - lo) <= (hi - lo) as
+ *     unsigned bytes, i.e. min(b - lo, hi - lo) == b - lo; the first clear
+ *     bit of the OR over all ranges is the first escaping byte
+ *   - The tail shorter than 16 bytes (or everything without SSE2) is scanned
+ *     one byte at a time
+ */
+
+static int lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static bool leaves(const DFAAccel& accel, unsigned char c) {
+    if (accel.kind == DFAAccel::ESCAPE_BYTES) {
+        for (int k = 0; k < accel.count; k++) {
+            if (c == accel.lo[k]) return true;
+        }
+        return false;
+    }
+    for (int k = 0; k < accel.count; k++) {
+        if (c >= accel.lo[k] && c <= accel.hi[k]) return false;
+    }
+    return true;
+}
+
+size_t accelScan(const DFAAccel& accel, const unsigned char* p, size_t n) {
+    size_t i = 0;
+    if (accel.kind == DFAAccel::ESCAPE_BYTES) {
+        if (accel.count == 0) return n;
+        if (accel.count == 1) {
+            const void* hit = std::memchr(p, accel.lo[0], n);
+            return hit ? static_cast<const unsigned char*>(hit) - p : n;
+        }
+    }
+
+#ifdef COMPILED_DFA_SSE2
+    __m128i lo[4], width[4];
+    for (int k = 0; k < accel.count; k++) {
+        lo[k] = _mm_set1_epi8(static_cast<char>(accel.lo[k]));
+        width[k] = _mm_set1_epi8(static_cast<char>(accel.hi[k] - accel.lo[k]));
+    }
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        unsigned mask;
+        if (accel.kind == DFAAccel::ESCAPE_BYTES) {
+            __m128i hit = _mm_cmpeq_epi8(v, lo[0]);
+            for (int k = 1; k < accel.count; k++) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, lo[k]));
+            mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        } else {
+            __m128i stay = _mm_setzero_si128();
+            for (int k = 0; k < accel.count; k++) {
+                __m128i offset = _mm_sub_epi8(v, lo[k]);
+                stay = _mm_or_si128(stay, _mm_cmpeq_epi8(_mm_min_epu8(offset, width[k]), offset));
+            }
+            mask = ~static_cast<unsigned>(_mm_movemask_epi8(stay)) & 0xFFFF;
+        }
+        if (mask != 0) return i + lowestBit(mask);
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (leaves(accel, p[i])) return i;
+    }
+    return n;
+}
+
+// Fills accel if state s of dfa is worth accelerating
+static bool findAccel(const DFA& dfa, int s, DFAAccel& accel) {
+    accel = DFAAccel{DFAAccel::ESCAPE_BYTES, 0, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    int escapes = 0;
+    for (int c = 0; c < 256; c++) {
+        if (dfa.next(s, static_cast<unsigned char>(c)) == s) continue;
+        if (++escapes > 3) break;
+        accel.lo[escapes - 1] = static_cast<uint8_t>(c);
+    }
+    if (escapes <= 3) {
+        accel.count = static_cast<uint8_t>(escapes);
+        return true;
+    }
+
+    accel.kind = DFAAccel::STAY_RANGES;
+    int ranges = 0, stayBytes = 0;
+    for (int c = 0; c < 256; c++) {
+        if (dfa.next(s, static_cast<unsigned char>(c)) != s) continue;
+        stayBytes++;
+        if (ranges > 0 && accel.hi[ranges - 1] == c - 1) {
+            accel.hi[ranges - 1] = static_cast<uint8_t>(c);
+            continue;
+        }
+        if (++ranges > 4) return false;
+        accel.lo[ranges - 1] = accel.hi[ranges - 1] = static_cast<uint8_t>(c);
+    }
+    accel.count = static_cast<uint8_t>(ranges);
+    return stayBytes >= CompiledDFA::MIN_STAY_BYTES;
+}
+
+// Chooses a default per row (its most common target) and packs the remaining
+// classes of every row into the shared comb by first fit, densest rows first
+template <typename Id>
+static void packRows(const std::vector<int32_t>& dense, int rows, int stride, int classCount, DFATables<Id>& t) {
+    t.rowDefault.assign(rows, 0);
+    t.rowBase.assign(rows, 0);
+    std::vector<std::vector<int>> exceptions(rows);
+    std::map<int32_t, int> counts;
+    for (int r = 0; r < rows; r++) {
+        const int32_t* in = &dense[static_cast<size_t>(r) * stride];
+        counts.clear();
+        for (int c = 0; c < classCount; c++) counts[in[c]]++;
+        int32_t best = in[0];
+        for (const auto& entry : counts) {
+            if (entry.second > counts[best]) best = entry.first;
+        }
+        t.rowDefault[r] = static_cast<Id>(best);
+        for (int c = 0; c < classCount; c++) {
+            if (in[c] != best) exceptions[r].push_back(c);
+        }
+    }
+
+    std::vector<int> order(rows);
+    for (int r = 0; r < rows; r++) order[r] = r;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return exceptions[a].size() > exceptions[b].size(); });
+
+    std::vector<char> used;
+    size_t firstFree = 0, combSize = 0;
+    for (int r : order) {
+        const std::vector<int>& cols = exceptions[r];
+        size_t base = 0;
+        if (!cols.empty()) {
+            base = firstFree > static_cast<size_t>(cols[0]) ? firstFree - cols[0] : 0;
+            for (;; base++) {
+                bool fits = true;
+                for (int c : cols) {
+                    if (base + c < used.size() && used[base + c]) {
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits) break;
+            }
+            if (used.size() < base + stride) used.resize(base + stride, 0);
+            for (int c : cols) used[base + c] = 1;
+            while (firstFree < used.size() && used[firstFree]) firstFree++;
+        }
+        t.rowBase[r] = static_cast<uint32_t>(base);
+        combSize = std::max(combSize, base + stride);  // Every class of the row stays in bounds
+    }
+
+    t.combNext.assign(combSize, 0);
+    t.combCheck.assign(combSize, DFATables<Id>::EMPTY);
+    for (int r = 0; r < rows; r++) {
+        for (int c : exceptions[r]) {
+            t.combNext[t.rowBase[r] + c] = static_cast<Id>(dense[static_cast<size_t>(r) * stride + c]);
+            t.combCheck[t.rowBase[r] + c] = static_cast<Id>(r);
+        }
+    }
+}
+
+// Stores the premultiplied table in width Id, row-compressed when the dense
+// form exceeds the budget
+template <typename Id>
+static CompiledDFA::Layout storeTables(const std::vector<int32_t>& dense, int rows, int stride, int classCount,
+                                       size_t denseBudget, DFATables<Id>& t) {
+    if (dense.size() * sizeof(Id) > denseBudget) {
+        packRows(dense, rows, stride, classCount, t);
+        return CompiledDFA::ROW_COMPRESSED;
+    }
+    t.dense.assign(dense.begin(), dense.end());
+    return CompiledDFA::DENSE;
+}
+
+CompiledDFA compileDFA(const DFA& dfa, size_t denseBudget) {
+    CompiledDFA compiled;
+    int n = dfa.stateCount();
+
+    std::map<std::vector<int>, int> columns;
+    std::vector<int> column(n);
+    for (int c = 0; c < 256; c++) {
+        for (int s = 0; s < n; s++) column[s] = dfa.next(s, static_cast<unsigned char>(c));
+        auto it = columns.emplace(column, static_cast<int>(columns.size())).first;
+        compiled.byteClass[c] = static_cast<uint8_t>(it->second);
+    }
+    compiled.classCount = n > 0 ? static_cast<int>(columns.size()) : 1;
+    while ((1 << compiled.strideShift) < compiled.classCount) compiled.strideShift++;
+
+    // Row 0 = dead, then accelerated, then accepting, then the rest
+    std::vector<int> row(n, 0);
+    int nextRow = 1;
+    DFAAccel accel;
+    for (int s = 0; s < n; s++) {
+        if (findAccel(dfa, s, accel)) {
+            row[s] = nextRow++;
+            compiled.accels.push_back(accel);
+        }
+    }
+    int acceleratedRows = nextRow - 1;
+    for (int s = 0; s < n; s++) {
+        if (row[s] == 0 && dfa.isAccepting(s)) row[s] = nextRow++;
+    }
+    int specialRows = nextRow - 1;
+    for (int s = 0; s < n; s++) {
+        if (row[s] == 0) row[s] = nextRow++;
+    }
+
+    int stride = 1 << compiled.strideShift;
+    std::vector<int32_t> table(static_cast<size_t>(n + 1) * stride, CompiledDFA::DEAD);
+    compiled.acceptTag.assign(n + 1, -1);
+    for (int s = 0; s < n; s++) {
+        int32_t* out = &table[static_cast<size_t>(row[s]) * stride];
+        for (int c = 0; c < 256; c++) {
+            int t = dfa.next(s, static_cast<unsigned char>(c));
+            out[compiled.byteClass[c]] = (t == DFA::DEAD_STATE) ? CompiledDFA::DEAD : row[t] << compiled.strideShift;
+        }
+        compiled.acceptTag[row[s]] = dfa.acceptTag[s];
+    }
+
+    compiled.start = (n > 0) ? row[dfa.start] << compiled.strideShift : CompiledDFA::DEAD;
+    compiled.lastAccel = acceleratedRows << compiled.strideShift;
+    compiled.lastSpecial = specialRows << compiled.strideShift;
+
+    // The largest ID (and row index, kept in combCheck) must stay below EMPTY
+    int64_t maxId = static_cast<int64_t>(n) << compiled.strideShift;
+    if (maxId < 0xFF) {
+        compiled.idBytes = 1;
+        compiled.layout = storeTables(table, n + 1, stride, compiled.classCount, denseBudget, compiled.tables8);
+    } else if (maxId < 0xFFFF) {
+        compiled.idBytes = 2;
+        compiled.layout = storeTables(table, n + 1, stride, compiled.classCount, denseBudget, compiled.tables16);
+    } else {
+        compiled.idBytes = 4;
+        compiled.layout = storeTables(table, n + 1, stride, compiled.classCount, denseBudget, compiled.tables32);
+    }
+
+    if (acceleratedRows == 0) buildSheng(dfa, compiled.sheng);
+    return compiled;
+}
+
+template <typename Id>
+struct DenseStep {
+    const Id* table;
+
+    int32_t operator()(int32_t s, unsigned cls) const { return table[s + cls]; }
+};
+
+template <typename Id>
+struct CombStep {
+    const Id* rowDefault;
+    const uint32_t* rowBase;
+    const Id* combNext;
+    const Id* combCheck;
+    int shift;
+
+    int32_t operator()(int32_t s, unsigned cls) const {
+        int32_t row = s >> shift;
+        uint32_t i = rowBase[row] + cls;
+        return combCheck[i] == static_cast<Id>(row) ? combNext[i] : rowDefault[row];
+    }
+};
+
+template <typename Id, typename Run>
+static auto withLayout(const CompiledDFA& dfa, const DFATables<Id>& t, Run run) {
+    if (dfa.layout == CompiledDFA::DENSE) return run(DenseStep<Id>{t.dense.data()});
+    return run(CombStep<Id>{t.rowDefault.data(), t.rowBase.data(), t.combNext.data(), t.combCheck.data(),
+                            dfa.strideShift});
+}
+
+// Calls run(step) with the step functor for this DFA's width and layout
+template <typename Run>
+static auto withStep(const CompiledDFA& dfa, Run run) {
+    if (dfa.idBytes == 1) return withLayout(dfa, dfa.tables8, run);
+    if (dfa.idBytes == 2) return withLayout(dfa, dfa.tables16, run);
+    return withLayout(dfa, dfa.tables32, run);
+}
+
+template <typename Step>
+static bool matchLoop(const CompiledDFA& dfa, Step step, const unsigned char* p, const unsigned char* end) {
+    const uint8_t* cls = dfa.byteClass.data();
+    int32_t lastAccel = dfa.lastAccel;
+    int32_t s = dfa.start;
+
+    for (;;) {
+        while (end - p >= 4 && s > lastAccel) {
+            s = step(s, cls[p[0]]);
+            s = step(s, cls[p[1]]);
+            s = step(s, cls[p[2]]);
+            s = step(s, cls[p[3]]);
+            p += 4;
+        }
+        if (s == CompiledDFA::DEAD) return false;
+        if (s > lastAccel || end - p < CompiledDFA::MIN_SCAN) break;  // Short tail: plain steps
+
+        p += dfa.skip(s, p, end - p);
+        if (p == end) break;
+        s = step(s, cls[*p++]);  // The escape byte
+    }
+    while (p < end) s = step(s, cls[*p++]);
+    return dfa.isAccepting(s);
+}
+
+template <typename Step>
+static size_t longestLoop(const CompiledDFA& dfa, Step step, const unsigned char* p, size_t size, int& tag) {
+    const uint8_t* cls = dfa.byteClass.data();
+    int32_t lastSpecial = dfa.lastSpecial;
+    int32_t s = dfa.start;
+    size_t best = 0;
+    tag = -1;
+
+    for (size_t i = 0; i < size; i++) {
+        s = step(s, cls[p[i]]);
+        if (s > lastSpecial) continue;
+        if (s == CompiledDFA::DEAD) break;
+        bool accepting = dfa.isAccepting(s);
+        if (s <= dfa.lastAccel && size - i > static_cast<size_t>(CompiledDFA::MIN_SCAN)) {
+            i += dfa.skip(s, p + i + 1, size - i - 1);
+        }
+        if (accepting) {
+            tag = dfa.tag(s);
+            best = i + 1;
+        }
+    }
+    return best;
+}
+
+int32_t CompiledDFA::next(int32_t id, unsigned char c) const {
+    return withStep(*this, [&](auto step) { return step(id, byteClass[c]); });
+}
+
+bool CompiledDFA::matches(const char* data, size_t size) const {
+    if (!sheng.empty()) return shengMatches(sheng, data, size);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return withStep(*this, [&](auto step) { return matchLoop(*this, step, p, p + size); });
+}
+
+size_t CompiledDFA::longestMatch(const char* data, size_t size, int& tag) const {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return withStep(*this, [&](auto step) { return longestLoop(*this, step, p, size, tag); });
+}
+
+size_t CompiledDFA::memoryBytes() const {
+    return tables8.memoryBytes() + tables16.memoryBytes() + tables32.memoryBytes() + sizeof(byteClass) +
+           acceptTag.size() * sizeof(int) + accels.size() * sizeof(DFAAccel) + sheng.masks.size();
+}
@@ -0,0 +1,166 @@
+#ifndef COMPILED_DFA_H
+#define COMPILED_DFA_H
+
+#include "dfa_construction.h"
+#include "sheng_dfa.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * FILE: compiled_dfa.h
+ * DESCRIPTION: Match-time DFA layout with premultiplied state IDs
+ * PROCESS:
+ *
+ *   DFA (dfa_construction.h) is the construction form: logical state numbers,
+ *   a 256-column row per state and a separate accept table. Every step costs
+ *   a multiply, a DEAD_STATE check, and another load for acceptance.
+ *   CompiledDFA is the form the matchers run on:
+ *
+ *   1. Byte classes
+ *      - Bytes that no state tells apart share one column; byteClass[b]
+ *        maps a byte to its column ("[ACGT]+" needs 2 columns, not 256)
+ *      - Rows are padded to a power-of-two stride (1 << strideShift)
+ *
+ *   2. Premultiplied state IDs
+ *      - A state's ID is its row number times the stride, i.e. the offset
+ *        of its row in the table, so a step is one add and one load:
+ *            s = table[s + byteClass[b]]
+ *
+ *   3. Special states in reserved ID ranges (structure of arrays)
+ *      - Row 0 is the dead state: ID 0, every column maps back to 0
+ *      - Then accelerated rows (section 4), then the remaining accepting
+ *        rows, then the rest, so
+ *            s <= lastSpecial   <=>   dead, accelerated or accepting
+ *        is one comparison on the ID itself, with no flag load
+ *      - acceptTag (rule index for the lexer) is a separate array indexed by
+ *        row and is only read for special states
+ *
+ *   4. Accelerated states (DFAAccel)
+ *      - A state that loops on most bytes and leaves on a few is recorded
+ *        with its escape bytes (at most 3; 0 = it never leaves, e.g. .*)
+ *      - A state whose self-loop bytes form at most 4 ranges covering at
+ *        least MIN_STAY_BYTES bytes (identifier tails [a-zA-Z0-9]*) is
+ *        recorded with those ranges
+ *      - accelScan() finds the next byte that leaves the state: memchr for
+ *        one escape byte, otherwise 16 bytes per SSE2 compare (scalar loop
+ *        when SSE2 is not available), so the matcher jumps over the run
+ *        instead of stepping through it
+ *      - Accelerated rows come right after the dead row:
+ *            s <= lastAccel   <=>   dead or accelerated
+ *      - Matchers only scan when at least MIN_SCAN bytes are left; shorter
+ *        tails are cheaper to step through the table
+ *
+ *   5. Compact storage
+ *      - IDs are stored in the narrowest width that holds the largest ID:
+ *        8 bits (<= 255), 16 bits, or 32 bits
+ *      - DENSE: one full row per state (the layout of section 2)
+ *      - ROW_COMPRESSED, when the dense table would exceed the budget
+ *        (DENSE_BUDGET, 256 KiB): each row keeps a default target (its most
+ *        common one, usually the dead state) plus exceptions, packed into one
+ *        shared comb vector by first fit:
+ *            i = rowBase[row] + class
+ *            s = combCheck[i] == row ? combNext[i] : rowDefault[row]
+ *        still O(1) with no search, and IDs stay premultiplied so the
+ *        special ranges are unchanged
+ *
+ *   6. matches() / longestMatch()
+ *      - One template loop per (width, layout), picked once per call
+ *      - The dead row is absorbing, so the dead/accelerated check in
+ *        matches() is made once per four bytes instead of once per byte; an
+ *        accelerated state entered mid-block is picked up after the block
+ *      - longestMatch() is the lexer's maximal-munch scan: one isSpecial()
+ *        comparison per byte
+ *
+ *   7. Small automata (sheng_dfa.h)
+ *      - When the DFA fits in 16 states (dead state included) and has no
+ *        accelerated state, compileDFA() also builds a ShengDFA and
+ *        matches() runs on it: one shuffle per byte instead of a dependent
+ *        table load. Larger automata, or ones where skipping runs pays off
+ *        more, stay on the table
+ *
+ *   8. compileDFA(dfa[, denseBudget]): builds the layout from any DFA
+ *      (construction, minimization or boolean operations); minimize first
+ *      so that more automata fit the Sheng engine. denseBudget = 0 forces
+ *      row compression
+ */
+
+struct DFAAccel {
+    enum Kind : uint8_t { ESCAPE_BYTES, STAY_RANGES };
+
+    Kind kind;
+    uint8_t count;   // Escape bytes (0..3) or stay ranges (1..4)
+    uint8_t lo[4];   // Escape bytes, or range starts
+    uint8_t hi[4];   // Range ends (STAY_RANGES only)
+};
+
+// Offset of the first byte in p[0 .. n) that leaves the state, n if none does
+size_t accelScan(const DFAAccel& accel, const unsigned char* p, size_t n);
+
+// Transition storage for one ID width (uint8_t, uint16_t or int32_t)
+template <typename Id>
+struct DFATables {
+    std::vector<Id> dense;           // DENSE: next = dense[id + class]
+    std::vector<Id> rowDefault;      // ROW_COMPRESSED, by row: target of every class not listed
+    std::vector<uint32_t> rowBase;   // ROW_COMPRESSED, by row: offset of its exceptions in comb
+    std::vector<Id> combNext;        // Exception targets, rows interleaved
+    std::vector<Id> combCheck;       // Row owning each comb slot; EMPTY = free
+
+    static constexpr Id EMPTY = static_cast<Id>(-1);
+
+    size_t memoryBytes() const {
+        return (dense.size() + rowDefault.size() + combNext.size() + combCheck.size()) * sizeof(Id) +
+               rowBase.size() * sizeof(uint32_t);
+    }
+};
+
+struct CompiledDFA {
+    enum Layout : uint8_t { DENSE, ROW_COMPRESSED };
+
+    static constexpr int32_t DEAD = 0;
+    static constexpr int MIN_STAY_BYTES = 16;
+    static constexpr ptrdiff_t MIN_SCAN = 16;          // Shorter runs are cheaper to step than to scan
+    static constexpr size_t DENSE_BUDGET = 256 * 1024;  // Bytes; larger dense tables are row-compressed
+
+    std::array<uint8_t, 256> byteClass{};
+    int classCount = 1;
+    int strideShift = 0;
+    int32_t start = DEAD;
+    int32_t lastAccel = DEAD;        // IDs in [DEAD, lastAccel] are dead or accelerated
+    int32_t lastSpecial = DEAD;      // IDs in [DEAD, lastSpecial] are dead, accelerated or accepting
+    std::vector<int> acceptTag;      // By row (id >> strideShift); -1 = non-accepting
+    std::vector<DFAAccel> accels;    // By row, for rows 1 .. lastAccel >> strideShift
+    ShengDFA sheng;                  // Built for small automata; empty otherwise
+
+    Layout layout = DENSE;
+    int idBytes = 4;                 // Width of the stored IDs: 1, 2 or 4
+    DFATables<uint8_t> tables8;      // Only the table of width idBytes is filled
+    DFATables<uint16_t> tables16;
+    DFATables<int32_t> tables32;
+
+    int stateCount() const { return static_cast<int>(acceptTag.size()); }  // Includes the dead row
+    int32_t next(int32_t id, unsigned char c) const;
+    bool isSpecial(int32_t id) const { return id <= lastSpecial; }
+    bool isAccelerated(int32_t id) const { return id != DEAD && id <= lastAccel; }
+    bool isAccepting(int32_t id) const { return acceptTag[id >> strideShift] >= 0; }
+    int tag(int32_t id) const { return acceptTag[id >> strideShift]; }
+    size_t memoryBytes() const;
+
+    // Bytes of p[0 .. n) that an accelerated state consumes without leaving
+    size_t skip(int32_t id, const unsigned char* p, size_t n) const {
+        return accelScan(accels[(id >> strideShift) - 1], p, n);
+    }
+
+    // Whole-input acceptance
+    bool matches(const char* data, size_t size) const;
+    bool matches(const std::string& input) const { return matches(input.data(), input.size()); }
+
+    // Longest accepted prefix of data: its length, with its accept tag in tag (-1 = none)
+    size_t longestMatch(const char* data, size_t size, int& tag) const;
+};
+
+CompiledDFA compileDFA(const DFA& dfa, size_t denseBudget = CompiledDFA::DENSE_BUDGET);
+
+#endif
@@ -0,0 +1,272 @@
+#include "counting_set_automaton.h"
+#include "nfa_simulator.h"
+#include "match_context.h"
+#include <map>
+#include <set>
+#include <queue>
+#include <algorithm>
+
+/**
+ * FILE: counting_set_automaton.cpp
+ * DESCRIPTION: Implementation of counting-set simulation
+ * PROCESS:
+ *
+ *   CountingSet:
+ *   - A value inserted when offset was t has value (offset - t) now, so one
+ *     offset++ increments every member; insertions at consecutive offsets
+ *     form one run [first, last] of stamps
+ *   - increment(): offset++, drop stamps whose value exceeds max, then keep
+ *     only the youngest stamp among those with value >= min (dominance)
+ *   - canExit(): oldest surviving value >= min (all survivors are <= max)
+ *   - Dropped runs are skipped with a head index and compacted lazily,
+ *     so every operation is amortized O(1)
+ *
+ *   buildCountingNFA():
+ *   - BFS over every state reachable from the start state
+ *   - A counter check state qualifies when its loop state has only byte
+ *     transitions into one state whose sole ε-edge leads back to the check
+ *   - compileProgram(): BFS order becomes the dense state numbering
+ *
+ *   simulateCountingNFA():
+ *   - closure() is the ordinary ε-closure, except that at a repeat entry it
+ *     records "insert 0" instead of walking into the counted body, and
+ *     continues at the exit directly for {0,m}
+ *   - closure() runs on the context's explicit stack; the target set
+ *     doubles as the visited mark
+ *   - current / next are ActiveStates: a bitset while many states are
+ *     active, a sparse set when a large automaton has only a few
+ *   - Time: O(|input| * (|NFA states| + |repeats|)), independent of n and m
+ */
+
+void CountingSet::clear() {
+    runs.clear();
+    head = 0;
+}
+
+void CountingSet::insertZero() {
+    if (!empty() && runs.back().last == offset) return;
+    if (!empty() && runs.back().last == offset - 1) {
+        runs.back().last = offset;
+        return;
+    }
+    runs.push_back({offset, offset});
+}
+
+void CountingSet::increment(int min, int max) {
+    offset++;
+
+    if (max >= 0) {
+        long long oldest = offset - max;  // Stamps below this exceed max
+        while (!empty() && runs[head].last < oldest) head++;
+        if (!empty() && runs[head].first < oldest) runs[head].first = oldest;
+    }
+
+    long long threshold = offset - min;   // Stamps up to this have value >= min
+    while (head + 1 < runs.size() && runs[head + 1].first <= threshold) head++;
+    if (!empty() && runs[head].first <= threshold) {
+        runs[head].first = std::min(runs[head].last, threshold);
+    }
+
+    if (head > 0 && head * 2 >= runs.size()) {
+        runs.erase(runs.begin(), runs.begin() + head);
+        head = 0;
+    }
+}
+
+bool CountingSet::canExit(int min) const {
+    return !empty() && runs[head].first <= offset - min;
+}
+
+// Fills repeat from a counter check state if its body consumes exactly one byte of a class
+static bool matchCountedRepeat(NFAState* check, CountedRepeat& repeat) {
+    const NFACounter& counter = StateManager::counterStore[check->counter];
+    NFAState* loop = counter.loop;
+    if (loop->counter >= 0 || !loop->epsilon.empty() || loop->transitions.empty()) return false;
+
+    NFAState* bodyEnd = nullptr;
+    repeat.bytes.reset();
+    for (const auto& [c, nexts] : loop->transitions) {
+        for (auto next : nexts) {
+            if (bodyEnd && next != bodyEnd) return false;
+            bodyEnd = next;
+        }
+        repeat.bytes.set(static_cast<unsigned char>(c));
+    }
+    if (!bodyEnd || bodyEnd->counter >= 0 || !bodyEnd->transitions.empty()) return false;
+    if (bodyEnd->epsilon.size() != 1 || bodyEnd->epsilon[0] != check) return false;
+
+    repeat.min = counter.min;
+    repeat.max = counter.max;
+    repeat.entry = counter.entry;
+    repeat.exit = counter.exit;
+    return true;
+}
+
+// Numbers the states in BFS order and flattens their edges into CSR arrays
+static void compileProgram(CountingNFA& cnfa, const std::vector<NFAState*>& order) {
+    std::map<NFAState*, int> index;
+    for (size_t i = 0; i < order.size(); i++) index[order[i]] = static_cast<int>(i);
+
+    cnfa.start = index[cnfa.nfa.start];
+    cnfa.repeatAt.assign(order.size(), -1);
+    for (size_t k = 0; k < cnfa.repeats.size(); k++) {
+        cnfa.repeatAt[index[cnfa.repeats[k].entry]] = static_cast<int>(k);
+        cnfa.repeats[k].exitIndex = index[cnfa.repeats[k].exit];
+    }
+
+    cnfa.epsilonStart.push_back(0);
+    cnfa.edgeStart.push_back(0);
+    for (NFAState* s : order) {
+        for (auto next : s->epsilon) cnfa.epsilonTargets.push_back(index[next]);
+        cnfa.epsilonStart.push_back(static_cast<int>(cnfa.epsilonTargets.size()));
+
+        size_t first = cnfa.edges.size();
+        for (const auto& [c, targets] : s->transitions) {
+            for (auto target : targets) {
+                int t = index[target];
+                size_t e = first;
+                while (e < cnfa.edges.size() && cnfa.edges[e].target != t) e++;
+                if (e == cnfa.edges.size()) cnfa.edges.push_back({{}, t});
+                cnfa.edges[e].bytes.set(static_cast<unsigned char>(c));
+            }
+        }
+        cnfa.edgeStart.push_back(static_cast<int>(cnfa.edges.size()));
+    }
+
+    for (auto f : cnfa.nfa.finals) {
+        auto it = index.find(f);
+        if (it != index.end()) cnfa.finals.push_back(it->second);
+    }
+}
+
+CountingNFA buildCountingNFA(NFAFragment nfa) {
+    CountingNFA cnfa;
+    cnfa.nfa = nfa;
+    cnfa.supported = true;
+
+    std::set<NFAState*> seen;
+    std::queue<NFAState*> work;
+    std::vector<NFAState*> order;
+    seen.insert(nfa.start);
+    work.push(nfa.start);
+
+    while (!work.empty()) {
+        NFAState* s = work.front(); work.pop();
+        order.push_back(s);
+
+        std::vector<NFAState*> nexts = s->epsilon;
+        for (const auto& [c, targets] : s->transitions) {
+            nexts.insert(nexts.end(), targets.begin(), targets.end());
+        }
+        if (s->counter >= 0) {
+            const NFACounter& counter = StateManager::counterStore[s->counter];
+            nexts.push_back(counter.loop);
+            nexts.push_back(counter.exit);
+
+            CountedRepeat repeat;
+            if (matchCountedRepeat(s, repeat)) {
+                cnfa.repeats.push_back(repeat);
+            } else {
+                cnfa.supported = false;
+            }
+        }
+
+        for (auto next : nexts) {
+            if (seen.insert(next).second) work.push(next);
+        }
+    }
+
+    if (!cnfa.supported) {
+        cnfa.repeats.clear();
+        return cnfa;
+    }
+    compileProgram(cnfa, order);
+    return cnfa;
+}
+
+static void closure(const CountingNFA& cnfa, int start, ActiveStates& states, MatchContext& context) {
+    std::vector<int>& stack = context.stack;
+    stack.push_back(start);
+    while (!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        if (!states.insert(s)) continue;
+
+        int k = cnfa.repeatAt[s];
+        if (k >= 0) {
+            context.inserts[k] = 1;
+            if (cnfa.repeats[k].min == 0) stack.push_back(cnfa.repeats[k].exitIndex);
+            continue;
+        }
+        for (int e = cnfa.epsilonStart[s]; e < cnfa.epsilonStart[s + 1]; e++) {
+            stack.push_back(cnfa.epsilonTargets[e]);
+        }
+    }
+}
+
+bool simulateCountingNFA(const CountingNFA& cnfa, const std::string& input) {
+    return simulateCountingNFA(cnfa, input.data(), input.size());
+}
+
+bool simulateCountingNFA(const CountingNFA& cnfa, const std::string& input, MatchContext& context) {
+    return simulateCountingNFA(cnfa, input.data(), input.size(), context);
+}
+
+bool simulateCountingNFA(const CountingNFA& cnfa, const char* data, size_t size) {
+    if (!cnfa.supported) return simulateNFA(cnfa.nfa, data, size);
+    PooledMatchContext context;
+    return simulateCountingNFA(cnfa, data, size, context.get());
+}
+
+bool simulateCountingNFA(const CountingNFA& cnfa, const char* data, size_t size, MatchContext& context) {
+    if (!cnfa.supported) return simulateNFA(cnfa.nfa, data, size);
+
+    size_t repeatCount = cnfa.repeats.size();
+    context.prepare(cnfa.stateCount(), repeatCount);
+    std::vector<CountingSet>& sets = context.sets;
+    std::vector<char>& inserts = context.inserts;
+    ActiveStates* current = &context.current;
+    ActiveStates* next = &context.next;
+
+    closure(cnfa, cnfa.start, *current, context);
+
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(data) + size;
+    for (const unsigned char* p = reinterpret_cast<const unsigned char*>(data); p < end; p++) {
+        unsigned char c = *p;
+        next->clear();
+        for (size_t k = 0; k < repeatCount; k++) {
+            if (inserts[k]) sets[k].insertZero();
+            inserts[k] = 0;
+        }
+
+        current->forEach([&](int s) {
+            for (int e = cnfa.edgeStart[s]; e < cnfa.edgeStart[s + 1]; e++) {
+                if (cnfa.edges[e].bytes.test(c)) closure(cnfa, cnfa.edges[e].target, *next, context);
+            }
+        });
+
+        for (size_t k = 0; k < repeatCount; k++) {
+            const CountedRepeat& repeat = cnfa.repeats[k];
+            if (!repeat.bytes.test(c)) {
+                sets[k].clear();
+                continue;
+            }
+            sets[k].increment(repeat.min, repeat.max);
+            if (sets[k].canExit(repeat.min)) closure(cnfa, repeat.exitIndex, *next, context);
+        }
+
+        std::swap(current, next);
+        if (current->empty()) {
+            bool live = false;
+            for (size_t k = 0; k < repeatCount && !live; k++) {
+                live = inserts[k] || !sets[k].empty();
+            }
+            if (!live) return false;
+        }
+    }
+
+    for (int f : cnfa.finals) {
+        if (current->contains(f)) return true;
+    }
+    return false;
+}
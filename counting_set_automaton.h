@@ -0,0 +1,106 @@
+#ifndef COUNTING_SET_AUTOMATON_H
+#define COUNTING_SET_AUTOMATON_H
+
+#include "nfa_state.h"
+#include <bitset>
+#include <string>
+#include <vector>
+
+/**
+ * FILE: counting_set_automaton.h
+ * DESCRIPTION: Counting-set simulation of bounded repetitions X{n,m}
+ * PROCESS:
+ *
+ *   Configuration simulation (nfa_simulator) keeps one configuration per
+ *   counter value, and subset construction unrolls every value into its own
+ *   DFA state: [ACGT]{50,500} costs up to 500 configurations / DFA states.
+ *   This engine keeps all values of one counter in a single counting set.
+ *
+ *   1. CountedRepeat: a repetition whose body consumes exactly one byte from
+ *      a class (a{1000}, [ACGT]{50,500}, .{3}). Every live value of such a
+ *      counter is incremented by the same byte, so the whole set moves at once
+ *
+ *   2. CountingSet: the values of one counter, stored as runs of insertion
+ *      stamps relative to a shared offset
+ *      - insert 0 / increment all: O(1) (extend a run / bump the offset)
+ *      - values above max are dropped from the oldest end
+ *      - values >= min are dominated by the smallest of them (it stays in
+ *        [min, max] longest), so only that one is kept
+ *      - size = number of separate entry runs, not a function of n or m
+ *
+ *   3. buildCountingNFA(nfa)
+ *      - Finds every NFACounter; if all are CountedRepeats the engine is
+ *        used, otherwise `supported` is false and simulation falls back to
+ *        simulateNFA()
+ *      - Compiles the reachable states into a dense program: states are
+ *        numbered 0..n-1, ε-edges and byte edges (grouped by target, one
+ *        256-bit class per edge) are stored in flat CSR arrays, so the
+ *        simulation never follows NFAState pointers or std::map nodes
+ *
+ *   4. simulateCountingNFA(cnfa, input[, context]), or (cnfa, data, size[, context])
+ *      to match a byte range without copying it into a std::string
+ *      - Plain NFA states outside counted bodies are tracked as a state set
+ *      - Reaching a repeat's entry marks "insert 0" for its counting set
+ *      - Per byte: step the plain states, then increment every counting set
+ *        whose class contains the byte (clear the others), then follow the
+ *        exit of every set holding a value in [min, max]
+ *      - All scratch lives in a MatchContext (match_context.h); without one
+ *        a context is leased from the thread-local pool
+ */
+
+struct CountedRepeat {
+    std::bitset<256> bytes;  // Class consumed by one iteration of the body
+    int min;
+    int max;                 // -1 = unbounded
+    NFAState* entry;
+    NFAState* exit;
+    int exitIndex = -1;      // Dense index of exit
+};
+
+class CountingSet {
+    struct Run { long long first; long long last; };  // Inclusive stamp range
+
+    std::vector<Run> runs;
+    size_t head = 0;
+    long long offset = 0;
+
+public:
+    bool empty() const { return head == runs.size(); }
+    void clear();
+    void insertZero();
+    void increment(int min, int max);
+    bool canExit(int min) const;
+    size_t runCount() const { return runs.size() - head; }
+};
+
+struct MatchContext;
+
+struct CountingNFA {
+    struct ByteEdge {
+        std::bitset<256> bytes;
+        int target;
+    };
+
+    NFAFragment nfa;
+    bool supported = false;
+    std::vector<CountedRepeat> repeats;
+
+    // Dense program, filled only when supported
+    int start = 0;
+    std::vector<int> repeatAt;        // State -> repeats[] index if it is a repeat entry, else -1
+    std::vector<int> epsilonStart;    // ε-targets of s: epsilonTargets[epsilonStart[s] .. epsilonStart[s+1])
+    std::vector<int> epsilonTargets;
+    std::vector<int> edgeStart;       // Byte edges of s: edges[edgeStart[s] .. edgeStart[s+1])
+    std::vector<ByteEdge> edges;
+    std::vector<int> finals;
+
+    size_t stateCount() const { return repeatAt.size(); }
+};
+
+CountingNFA buildCountingNFA(NFAFragment nfa);
+bool simulateCountingNFA(const CountingNFA& cnfa, const std::string& input);
+bool simulateCountingNFA(const CountingNFA& cnfa, const std::string& input, MatchContext& context);
+bool simulateCountingNFA(const CountingNFA& cnfa, const char* data, size_t size);
+bool simulateCountingNFA(const CountingNFA& cnfa, const char* data, size_t size, MatchContext& context);
+
+#endif
@@ -0,0 +1,248 @@
+#include "derivative_matcher.h"
+#include "regex_preprocessor.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * FILE: derivative_matcher.cpp
+ * DESCRIPTION: Hash-consed regex terms, derivatives and the lazy state cache
+ * PROCESS:
+ *
+ *   Constructor:
+ *   - Same token loop as regexToNFA(), but operators build terms on a stack;
+ *     IDs 0 and 1 are always ∅ and ε
+ *   - A stack entry is a concatenation kept as its list of factors: '.'
+ *     splices two lists (the shorter one moves), and the list is folded
+ *     into one right-nested term only when another operator needs it, so
+ *     a 20000-byte literal costs 20000 interns, not 20000² / 2
+ *   - The start state is the whole regex term
+ *
+ *   makeConcat():
+ *   - A concatenation on the left is unrolled into its factors with a loop
+ *     and re-nested onto the right operand: no recursion, however long
+ *
+ *   makeUnion():
+ *   - Operands are collected by walking both right-nested union chains,
+ *     sorted, deduplicated and stripped of ∅, then re-nested from the right
+ *
+ *   derivative():
+ *   - Memoized per (term, byte) across all states, so subterms shared by
+ *     several states are derived once
+ *   - Recursion follows the term structure; a concatenation only recurses
+ *     into its right side when the left side is nullable
+ *
+ *   matches():
+ *   - One cached load per byte; a missing entry computes the derivative,
+ *     looks up (or creates) its state and stores the edge
+ */
+
+size_t DerivativeMatcher::TermHash::operator()(const Term& t) const {
+    size_t h = t.kind;
+    for (int v : {t.a, t.b, t.min, t.max}) h = h * 1000003u ^ std::hash<int>()(v);
+    return h;
+}
+
+bool DerivativeMatcher::TermEqual::operator()(const Term& x, const Term& y) const {
+    return x.kind == y.kind && x.a == y.a && x.b == y.b && x.min == y.min && x.max == y.max;
+}
+
+int DerivativeMatcher::intern(Kind kind, int a, int b, int min, int max) {
+    bool nullable = false;
+    switch (kind) {
+        case NOTHING: case CLASS: nullable = false; break;
+        case EMPTY: case STAR: nullable = true; break;
+        case CONCAT: nullable = terms[a].nullable && terms[b].nullable; break;
+        case UNION: nullable = terms[a].nullable || terms[b].nullable; break;
+        case REPEAT: nullable = min == 0 || terms[a].nullable; break;
+    }
+    Term term{kind, a, b, min, max, nullable};
+    auto it = interned.emplace(term, static_cast<int>(terms.size()));
+    if (it.second) terms.push_back(term);
+    return it.first->second;
+}
+
+int DerivativeMatcher::makeClass(const std::bitset<256>& bytes) {
+    if (bytes.none()) return NOTHING;
+    auto it = classIndex.emplace(bytes, static_cast<int>(classes.size()));
+    if (it.second) classes.push_back(bytes);
+    return intern(CLASS, it.first->second);
+}
+
+int DerivativeMatcher::makeConcat(int r, int s) {
+    if (r == NOTHING || s == NOTHING) return NOTHING;
+    if (r == EMPTY) return s;
+    if (s == EMPTY) return r;
+    if (terms[r].kind != CONCAT) return intern(CONCAT, r, s);
+
+    std::vector<int> factors;
+    for (; terms[r].kind == CONCAT; r = terms[r].b) factors.push_back(terms[r].a);
+    factors.push_back(r);
+    for (size_t k = factors.size(); k-- > 0;) s = intern(CONCAT, factors[k], s);
+    return s;
+}
+
+int DerivativeMatcher::makeUnion(int r, int s) {
+    std::vector<int> operands;
+    for (int t : {r, s}) {
+        while (terms[t].kind == UNION) {
+            operands.push_back(terms[t].a);
+            t = terms[t].b;
+        }
+        operands.push_back(t);
+    }
+    std::sort(operands.begin(), operands.end());
+    operands.erase(std::unique(operands.begin(), operands.end()), operands.end());
+    if (operands.size() > 1 && operands[0] == NOTHING) operands.erase(operands.begin());
+
+    int result = operands.back();
+    for (size_t k = operands.size() - 1; k-- > 0;) result = intern(UNION, operands[k], result);
+    return result;
+}
+
+int DerivativeMatcher::makeStar(int r) {
+    if (r == NOTHING || r == EMPTY) return EMPTY;
+    if (terms[r].kind == STAR) return r;
+    return intern(STAR, r);
+}
+
+int DerivativeMatcher::makeRepeat(int r, int min, int max) {
+    if (max == 0 || r == EMPTY) return EMPTY;
+    if (r == NOTHING) return min == 0 ? EMPTY : NOTHING;
+    if (terms[r].nullable) min = 0;  // r{n,m} = r{0,m} when r matches ε
+    if (min == 0 && max < 0) return makeStar(r);
+    if (min == 1 && max == 1) return r;
+    return intern(REPEAT, r, -1, min, max);
+}
+
+int DerivativeMatcher::derivative(int r, unsigned char c) {
+    if (r == NOTHING || r == EMPTY) return NOTHING;
+    uint64_t key = static_cast<uint64_t>(r) << 8 | c;
+    auto cached = derivatives.find(key);
+    if (cached != derivatives.end()) return cached->second;
+
+    Term t = terms[r];  // Copy: terms grows below
+    int result = NOTHING;
+    switch (t.kind) {
+        case CLASS:
+            result = classes[t.a].test(c) ? EMPTY : NOTHING;
+            break;
+        case CONCAT:
+            result = makeConcat(derivative(t.a, c), t.b);
+            if (terms[t.a].nullable) result = makeUnion(result, derivative(t.b, c));
+            break;
+        case UNION:
+            result = makeUnion(derivative(t.a, c), derivative(t.b, c));
+            break;
+        case STAR:
+            result = makeConcat(derivative(t.a, c), r);
+            break;
+        case REPEAT:
+            result = makeConcat(derivative(t.a, c),
+                                makeRepeat(t.a, std::max(t.min - 1, 0), t.max < 0 ? -1 : t.max - 1));
+            break;
+        default:
+            break;
+    }
+    derivatives.emplace(key, result);
+    return result;
+}
+
+int DerivativeMatcher::stateFor(int term) {
+    auto it = stateOf.find(term);
+    if (it != stateOf.end()) return it->second;
+    if (stateCount() >= maxStates) {
+        throw std::runtime_error("derivative matcher exceeds " + std::to_string(maxStates) + " states");
+    }
+    int state = stateCount();
+    if (term == NOTHING) dead = state;
+    stateOf.emplace(term, state);
+    stateTerm.push_back(term);
+    accepting.push_back(terms[term].nullable);
+    next.resize(next.size() + 256, -1);
+    return state;
+}
+
+int32_t DerivativeMatcher::step(int state, unsigned char c) {
+    int32_t target = stateFor(derivative(stateTerm[state], c));
+    next[static_cast<size_t>(state) * 256 + c] = target;
+    return target;
+}
+
+DerivativeMatcher::DerivativeMatcher(const std::string& postfix, int maxStates) : maxStates(maxStates) {
+    intern(NOTHING, -1);
+    intern(EMPTY, -1);
+
+    // Each entry is a concatenation as its list of factors: appending to a
+    // long literal is O(1), and the list becomes a term once
+    std::vector<std::deque<int>> stack;
+    auto push = [&](int term) {
+        stack.emplace_back();
+        for (; terms[term].kind == CONCAT; term = terms[term].b) stack.back().push_back(terms[term].a);
+        stack.back().push_back(term);
+    };
+    auto pop = [&]() {
+        int term = EMPTY;
+        for (auto it = stack.back().rbegin(); it != stack.back().rend(); ++it) term = makeConcat(*it, term);
+        stack.pop_back();
+        return term;
+    };
+
+    for (size_t i = 0; i < postfix.length();) {
+        size_t end = regexTokenEnd(postfix, i);
+        std::string token = postfix.substr(i, end - i);
+        char c = postfix[i];
+        i = end;
+
+        if (c == '.') {
+            if (stack.size() < 2) throw std::runtime_error("malformed regex (stack underflow on " + token + ")");
+            std::deque<int> s = std::move(stack.back());
+            stack.pop_back();
+            std::deque<int>& r = stack.back();
+            // Move the shorter list, so nesting in either direction stays linear
+            if (r.size() >= s.size()) {
+                r.insert(r.end(), s.begin(), s.end());
+            } else {
+                s.insert(s.begin(), r.begin(), r.end());
+                r = std::move(s);
+            }
+        } else if (c == '|') {
+            if (stack.size() < 2) throw std::runtime_error("malformed regex (stack underflow on " + token + ")");
+            int s = pop();
+            int r = pop();
+            push(makeUnion(r, s));
+        } else if (c == '*' || c == '+') {
+            if (stack.empty()) throw std::runtime_error("malformed regex (stack underflow on " + token + ")");
+            int r = pop();
+            push(c == '*' ? makeStar(r) : r);
+            if (c == '+') stack.back().push_back(makeStar(r));
+        } else if (c == '{') {
+            int min, max;
+            if (stack.empty() || !parseRepeat(token, min, max)) {
+                throw std::runtime_error("malformed regex (invalid repetition " + token + ")");
+            }
+            int r = pop();
+            push(makeRepeat(r, min, max));
+        } else {
+            std::bitset<256> bytes;
+            if (c == '[') bytes = parseCharacterClass(token);
+            else bytes.set(static_cast<unsigned char>(c == '\\' && token.length() == 2 ? token[1] : c));
+            push(makeClass(bytes));
+        }
+    }
+    if (stack.size() != 1) throw std::runtime_error("malformed regex");
+
+    start = stateFor(pop());
+}
+
+bool DerivativeMatcher::matches(const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    int32_t s = start;
+    for (size_t i = 0; i < size; i++) {
+        if (s == dead) return false;
+        int32_t t = next[static_cast<size_t>(s) * 256 + p[i]];
+        s = (t >= 0) ? t : step(s, p[i]);
+    }
+    return accepting[s];
+}
@@ -0,0 +1,109 @@
+#ifndef DERIVATIVE_MATCHER_H
+#define DERIVATIVE_MATCHER_H
+
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * FILE: derivative_matcher.h
+ * DESCRIPTION: Lazy DFA built from Brzozowski derivatives of the regex itself
+ * PROCESS:
+ *
+ *   Thompson NFA + subset construction pays for every state up front. For a
+ *   pattern compiled once and run on a few short inputs, most of those states
+ *   are never visited. DerivativeMatcher skips the NFA entirely:
+ *
+ *   1. Terms: the postfix regex is read into hash-consed terms
+ *      - ∅, ε, byte class, r·s, r|s, r*, r{n,m}; every term is interned, so
+ *        equal terms have equal IDs and comparing terms is comparing ints
+ *      - Smart constructors normalize as they build: ∅ and ε absorb or
+ *        vanish (∅·r = ∅, ε·r = r, r|∅ = r), r·s is kept right-nested, unions
+ *        are flattened, sorted by ID and deduplicated (r|r = r), (r*)* = r*.
+ *        This similarity rule keeps the number of distinct derivatives finite
+ *      - r+ is r·r*; r? is already r{0,1} after preprocessing
+ *
+ *   2. Derivative d_c(r): the language of r with a leading byte c removed
+ *      - d_c(class) = ε if c in class, else ∅
+ *      - d_c(r·s)   = d_c(r)·s | d_c(s) if r is nullable
+ *      - d_c(r|s)   = d_c(r) | d_c(s)
+ *      - d_c(r*)    = d_c(r)·r*
+ *      - d_c(r{n,m}) = d_c(r)·r{n-1,m-1}: the counter becomes part of the
+ *        term, so a{1000} needs no copies
+ *      - w is accepted iff d_w(r) is nullable
+ *
+ *   3. Lazy DFA
+ *      - Each distinct derivative term is a DFA state; a row of 256 cached
+ *        targets (-1 = not computed yet) is added when the state is first
+ *        reached, and an entry is filled the first time that byte is read
+ *        in that state
+ *      - Only states and edges the inputs actually visit are ever built;
+ *        later inputs reuse them, so the cost converges to a table DFA
+ *      - The ∅ state rejects immediately
+ *      - More than maxStates states throws std::runtime_error
+ *
+ *   4. Scope: byte semantics only (no --utf8 code-point classes); lazy
+ *      quantifiers match the same language as greedy ones. matches() fills
+ *      the cache, so a matcher is not shared between threads
+ */
+
+class DerivativeMatcher {
+public:
+    static constexpr int MAX_STATES = 1 << 16;
+
+    // postfix as produced by toPostfix(preprocessRegex(regex)); throws
+    // std::runtime_error when it is malformed
+    explicit DerivativeMatcher(const std::string& postfix, int maxStates = MAX_STATES);
+
+    bool matches(const char* data, size_t size);
+    bool matches(const std::string& input) { return matches(input.data(), input.size()); }
+
+    int stateCount() const { return static_cast<int>(stateTerm.size()); }
+    int termCount() const { return static_cast<int>(terms.size()); }
+
+private:
+    enum Kind : uint8_t { NOTHING, EMPTY, CLASS, CONCAT, UNION, STAR, REPEAT };
+
+    struct Term {
+        Kind kind;
+        int a, b;        // Operands (CLASS: index into classes)
+        int min, max;    // REPEAT bounds, max = -1 if unbounded
+        bool nullable;
+    };
+
+    struct TermHash {
+        size_t operator()(const Term& t) const;
+    };
+    struct TermEqual {
+        bool operator()(const Term& x, const Term& y) const;
+    };
+
+    std::vector<Term> terms;
+    std::unordered_map<Term, int, TermHash, TermEqual> interned;
+    std::vector<std::bitset<256>> classes;
+    std::unordered_map<std::bitset<256>, int> classIndex;
+    std::unordered_map<uint64_t, int> derivatives;   // (term << 8 | byte) -> derivative term
+
+    std::vector<int> stateTerm;                      // By state
+    std::unordered_map<int, int> stateOf;            // Term -> state
+    std::vector<int32_t> next;                       // next[state * 256 + byte]; -1 = not built
+    std::vector<char> accepting;                     // By state
+    int start = 0;
+    int dead = -1;                                   // State of ∅, once reached
+    int maxStates;
+
+    int intern(Kind kind, int a, int b = -1, int min = 0, int max = 0);
+    int makeClass(const std::bitset<256>& bytes);
+    int makeConcat(int r, int s);
+    int makeUnion(int r, int s);
+    int makeStar(int r);
+    int makeRepeat(int r, int min, int max);
+    int derivative(int r, unsigned char c);
+    int stateFor(int term);
+    int32_t step(int state, unsigned char c);
+};
+
+#endif
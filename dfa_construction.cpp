@@ -0,0 +1,168 @@
+#include "dfa_construction.h"
+#include "nfa_simulator.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+/**
+ * FILE: dfa_construction.cpp
+ * DESCRIPTION: Implementation of Subset Construction (Rabin & Scott)
+ * PROCESS:
+ *
+ *   subsetConstruction():
+ *   - Record which tag every NFA final state belongs to
+ *   - Start set = ε-closure of all NFA start states, registered as DFA state 0
+ *   - Worklist loop over unprocessed DFA states:
+ *     1. Group the byte transitions of all member states by character
+ *     2. For each character, take the ε-closure of the targets
+ *     3. Look the resulting set up in the map of known sets; create a new DFA
+ *        state if it has not been seen before
+ *     4. Write the transition into the 256-column table row
+ *   - determinizeStates(): counter-free NFAs. A set is a vector of NFA
+ *     states sorted by ID; closures come from one EpsilonClosure walker
+ *     (generation stamps, reserved stack) into a reused buffer, and the
+ *     per-byte target lists are reused too, so allocation is per new DFA
+ *     state, not per closure
+ *   - determinizeConfigs(): the first closure that reaches a counter check
+ *     state restarts the construction over sets of configurations (state
+ *     + counter values), so bounded repetitions {n,m} are unrolled here
+ *   - Accept tag of a DFA state = lowest tag among its NFA final states
+ *   - Creating state number stateLimit throws std::runtime_error
+ *   - Time: O(|DFA states| * |NFA states| * |alphabet|) worst case
+ */
+
+namespace {
+
+typedef std::map<NFAState*, int> FinalTags;
+
+// Lowest tag of tag and s's NFA, if s is a final state
+int lowerTag(const FinalTags& finalTag, NFAState* s, int tag) {
+    auto f = finalTag.find(s);
+    return (f != finalTag.end() && (tag < 0 || f->second < tag)) ? f->second : tag;
+}
+
+void addRow(DFA& dfa, int tag, size_t stateLimit) {
+    if (static_cast<size_t>(dfa.stateCount()) >= stateLimit) {
+        throw std::runtime_error("DFA state limit exceeded (" + std::to_string(stateLimit) + " states)");
+    }
+    dfa.acceptTag.push_back(tag);
+    dfa.transitions.resize(dfa.transitions.size() + 256, DFA::DEAD_STATE);
+}
+
+// Counter-free NFAs: DFA states are NFA state lists sorted by ID, built by
+// one EpsilonClosure walker into reused buffers. Returns false as soon as a
+// closure reaches a counter check state
+bool determinizeStates(const std::vector<NFAFragment>& nfas, const FinalTags& finalTag, size_t stateLimit,
+                       DFA& dfa) {
+    EpsilonClosure walker;
+    walker.reserve();
+    std::map<std::vector<NFAState*>, int> seen;
+    std::vector<const std::vector<NFAState*>*> subsets;  // Keys of seen, by DFA state
+    std::vector<std::vector<NFAState*>> moves(256);
+    std::vector<NFAState*> closure;
+
+    // DFA state of closure, added if new; -1 if the NFA has counters
+    auto addState = [&]() {
+        for (NFAState* s : closure) {
+            if (s->counter >= 0) return -1;
+        }
+        std::sort(closure.begin(), closure.end(), [](NFAState* x, NFAState* y) { return x->id < y->id; });
+        auto it = seen.find(closure);
+        if (it != seen.end()) return it->second;
+
+        int tag = -1;
+        for (NFAState* s : closure) tag = lowerTag(finalTag, s, tag);
+        int id = dfa.stateCount();
+        addRow(dfa, tag, stateLimit);
+        subsets.push_back(&seen.emplace(closure, id).first->first);
+        return id;
+    };
+
+    walker.begin();
+    for (const auto& nfa : nfas) walker.add(nfa.start, closure);
+    dfa.start = addState();
+    if (dfa.start < 0) return false;
+
+    for (int current = 0; current < dfa.stateCount(); current++) {
+        for (NFAState* s : *subsets[current]) {
+            for (const auto& [c, nexts] : s->transitions) {
+                std::vector<NFAState*>& targets = moves[static_cast<unsigned char>(c)];
+                targets.insert(targets.end(), nexts.begin(), nexts.end());
+            }
+        }
+
+        for (int c = 0; c < 256; c++) {
+            if (moves[c].empty()) continue;
+            closure.clear();
+            walker.begin();
+            for (NFAState* t : moves[c]) walker.add(t, closure);
+            moves[c].clear();
+            int target = addState();
+            if (target < 0) return false;
+            dfa.transitions[current * 256 + c] = target;
+        }
+    }
+    return true;
+}
+
+// NFAs with counters: DFA states are sets of (state, counter values) configurations
+void determinizeConfigs(const std::vector<NFAFragment>& nfas, const FinalTags& finalTag, size_t stateLimit,
+                        DFA& dfa) {
+    std::map<std::set<NFAConfig>, int> seen;
+    std::vector<std::set<NFAConfig>> subsets;
+
+    auto addState = [&](const std::set<NFAConfig>& configs) {
+        auto it = seen.find(configs);
+        if (it != seen.end()) return it->second;
+
+        int tag = -1;
+        for (const auto& config : configs) tag = lowerTag(finalTag, config.state, tag);
+        int id = dfa.stateCount();
+        addRow(dfa, tag, stateLimit);
+        seen[configs] = id;
+        subsets.push_back(configs);
+        return id;
+    };
+
+    std::set<NFAConfig> startSet;
+    for (const auto& nfa : nfas) getConfigClosure({nfa.start, {}}, startSet);
+    dfa.start = addState(startSet);
+
+    for (int current = 0; current < dfa.stateCount(); current++) {
+        std::map<char, std::set<NFAConfig>> moves;
+        for (const auto& config : subsets[current]) {
+            for (const auto& [c, nexts] : config.state->transitions) {
+                for (auto next : nexts) {
+                    getConfigClosure({next, config.counts}, moves[c]);
+                }
+            }
+        }
+
+        for (const auto& [c, targets] : moves) {
+            int target = addState(targets);
+            dfa.transitions[current * 256 + static_cast<unsigned char>(c)] = target;
+        }
+    }
+}
+
+}  // namespace
+
+DFA subsetConstruction(const std::vector<NFAFragment>& nfas, size_t stateLimit) {
+    FinalTags finalTag;
+    for (size_t tag = 0; tag < nfas.size(); tag++) {
+        for (auto f : nfas[tag].finals) {
+            if (!finalTag.count(f)) finalTag[f] = static_cast<int>(tag);
+        }
+    }
+
+    DFA dfa;
+    if (determinizeStates(nfas, finalTag, stateLimit, dfa)) return dfa;
+    dfa = DFA();
+    determinizeConfigs(nfas, finalTag, stateLimit, dfa);
+    return dfa;
+}
+
+DFA buildDFA(NFAFragment nfa, size_t stateLimit) {
+    return subsetConstruction({nfa}, stateLimit);
+}
@@ -0,0 +1,58 @@
+#ifndef DFA_CONSTRUCTION_H
+#define DFA_CONSTRUCTION_H
+
+#include "nfa_state.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * FILE: dfa_construction.h
+ * DESCRIPTION: Subset Construction - converts one or more NFAs into a single DFA
+ * PROCESS:
+ *
+ *   1. DFA: Table-driven deterministic automaton
+ *      - Dense transition table: stateCount rows x 256 byte columns
+ *      - A missing transition is stored as DEAD_STATE (-1)
+ *      - acceptTag[s] is -1 for non-accepting states, otherwise the tag of the
+ *        accepting NFA (the lowest tag wins when several NFAs accept together)
+ *      - matches(): whole-input acceptance, one table lookup per byte
+ *
+ *   2. subsetConstruction(nfas)
+ *      - Each NFA in the list is tagged with its index
+ *      - DFA start = union of the ε-closures of every NFA start state
+ *      - Each DFA state is a set of NFA states; new sets are discovered with
+ *        a worklist, one move + ε-closure per input character
+ *      - Used by the lexer generator to build one priority-tagged DFA
+ *      - stateLimit bounds the determinization blow-up: exceeding it throws
+ *        std::runtime_error instead of exhausting memory
+ *
+ *   3. buildDFA(nfa) - Single-pattern convenience wrapper (tag 0)
+ */
+
+struct DFA {
+    static constexpr int DEAD_STATE = -1;
+
+    int start = 0;
+    std::vector<int> transitions;  // Row-major: transitions[state * 256 + byte]
+    std::vector<int> acceptTag;    // -1 = non-accepting, otherwise NFA tag
+
+    int stateCount() const { return static_cast<int>(acceptTag.size()); }
+    int next(int state, unsigned char c) const { return transitions[state * 256 + c]; }
+    bool isAccepting(int state) const { return acceptTag[state] >= 0; }
+
+    bool matches(const char* data, size_t size) const {
+        int state = start;
+        for (size_t i = 0; i < size && state != DEAD_STATE; i++) {
+            state = next(state, static_cast<unsigned char>(data[i]));
+        }
+        return state != DEAD_STATE && isAccepting(state);
+    }
+    bool matches(const std::string& input) const { return matches(input.data(), input.size()); }
+};
+
+DFA subsetConstruction(const std::vector<NFAFragment>& nfas, size_t stateLimit = SIZE_MAX);
+DFA buildDFA(NFAFragment nfa, size_t stateLimit = SIZE_MAX);
+
+#endif
@@ -0,0 +1,269 @@
+#include "dfa_jit.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <vector>
+#if defined(ATFL_JIT) && defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define DFA_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * FILE: dfa_jit.cpp
+ * DESCRIPTION: x86-64 code generation and the invocation-counting wrapper
+ * PROCESS:
+ *
+ *   compile():
+ *   - Labels: row r of the compiled DFA is label r, so the dead row (0) is
+ *     the reject block and rowCount is the accept block
+ *   - stateRanges(): one pass over the 256 bytes of a row, cutting a new
+ *     range whenever the target row changes
+ *   - Jumps are emitted with a zero rel32 and patched once every block's
+ *     offset is known (rel32 = label - end of the jump instruction)
+ *   - Registers: rdi = p, rsi = end, eax = current byte, ecx = scratch,
+ *     rdx = membership tables (lea rip-relative once on entry); nothing
+ *     callee-saved is touched, so there is no prologue
+ *   - Tables are deduplicated by content and aligned to 64 bytes after
+ *     the code (int3 padding)
+ *
+ *   HotDFA::matches():
+ *   - Loaded entry point: call it
+ *   - Otherwise count the call; the call that sees calls == threshold
+ *     compiles and, on success, publishes the entry point
+ *   - Past the threshold (compile() failed, or no JIT in this build) the
+ *     counter is only loaded, so a shared table fallback does no atomic
+ *     read-modify-write per call
+ *   - With a Sheng engine the counter is never started
+ */
+
+#ifdef DFA_JIT_X86_64
+namespace {
+
+struct ByteRange {
+    int lo, hi;
+    int target;  // Row
+};
+
+class Assembler {
+    struct Fixup {
+        size_t at;
+        int label;
+    };
+
+    std::vector<Fixup> fixups;
+    std::vector<size_t> labels;
+
+public:
+    std::vector<uint8_t> code;
+
+    int newLabel() {
+        labels.push_back(0);
+        return static_cast<int>(labels.size()) - 1;
+    }
+    void emit(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+    void imm32(uint32_t value) {
+        for (int k = 0; k < 4; k++) code.push_back(static_cast<uint8_t>(value >> (8 * k)));
+    }
+    void bind(int label) { labels[label] = code.size(); }
+    // rel32 to label, patched later (jumps and RIP-relative operands)
+    void rel32(int label) {
+        fixups.push_back({code.size(), label});
+        imm32(0);
+    }
+    void jump(std::initializer_list<uint8_t> opcode, int label) {
+        emit(opcode);
+        rel32(label);
+    }
+    void patch() {
+        for (const auto& f : fixups) {
+            uint32_t rel = static_cast<uint32_t>(labels[f.label] - (f.at + 4));
+            for (int k = 0; k < 4; k++) code[f.at + k] = static_cast<uint8_t>(rel >> (8 * k));
+        }
+    }
+};
+
+typedef std::array<uint8_t, 256> ByteSet;
+
+// Membership tables, emitted after the code; identical sets share one table
+struct SetTables {
+    std::map<ByteSet, size_t> offsets;
+    std::vector<uint8_t> bytes;
+
+    size_t offsetOf(const ByteSet& set) {
+        auto it = offsets.emplace(set, bytes.size());
+        if (it.second) bytes.insert(bytes.end(), set.begin(), set.end());
+        return it.first->second;
+    }
+};
+
+const std::initializer_list<uint8_t> JMP = {0xE9};
+const std::initializer_list<uint8_t> JE = {0x0F, 0x84};
+const std::initializer_list<uint8_t> JNE = {0x0F, 0x85};
+const std::initializer_list<uint8_t> JBE = {0x0F, 0x86};
+const std::initializer_list<uint8_t> JAE = {0x0F, 0x83};
+
+std::vector<ByteRange> stateRanges(const CompiledDFA& dfa, int row) {
+    std::vector<ByteRange> ranges;
+    int32_t id = row << dfa.strideShift;
+    for (int c = 0; c < 256; c++) {
+        int target = dfa.next(id, static_cast<unsigned char>(c)) >> dfa.strideShift;
+        if (!ranges.empty() && ranges.back().target == target) {
+            ranges.back().hi = c;
+        } else {
+            ranges.push_back({c, c, target});
+        }
+    }
+    return ranges;
+}
+
+void emitRange(Assembler& a, const ByteRange& r) {
+    if (r.lo == r.hi) {
+        a.emit({0x3D});                                  // cmp eax, lo
+        a.imm32(r.lo);
+        a.jump(JE, r.target);
+    } else if (r.lo == 0) {
+        a.emit({0x3D});                                  // cmp eax, hi
+        a.imm32(r.hi);
+        a.jump(JBE, r.target);
+    } else if (r.hi == 255) {
+        a.emit({0x3D});                                  // cmp eax, lo
+        a.imm32(r.lo);
+        a.jump(JAE, r.target);
+    } else {
+        a.emit({0x8D, 0x88});                            // lea ecx, [rax - lo]
+        a.imm32(static_cast<uint32_t>(-r.lo));
+        a.emit({0x81, 0xF9});                            // cmp ecx, hi - lo
+        a.imm32(r.hi - r.lo);
+        a.jump(JBE, r.target);
+    }
+}
+
+// Checks for one state, one per target: a range compare when the target's
+// bytes form one range, a membership-table test otherwise. The target that
+// covers the most bytes is the jmp at the end
+bool emitTransitions(Assembler& a, SetTables& tables, const std::vector<ByteRange>& ranges, int rowCount) {
+    std::vector<int> bytesTo(rowCount, 0), rangesTo(rowCount, 0);
+    for (const auto& r : ranges) {
+        bytesTo[r.target] += r.hi - r.lo + 1;
+        rangesTo[r.target]++;
+    }
+    int fallback = static_cast<int>(std::max_element(bytesTo.begin(), bytesTo.end()) - bytesTo.begin());
+
+    std::vector<int> targets;
+    for (int t = 0; t < rowCount; t++) {
+        if (t != fallback && bytesTo[t] > 0) targets.push_back(t);
+    }
+    if (static_cast<int>(targets.size()) > DFAJit::MAX_TARGETS) return false;
+    std::stable_sort(targets.begin(), targets.end(), [&](int x, int y) { return bytesTo[x] > bytesTo[y]; });
+
+    for (int t : targets) {
+        if (rangesTo[t] == 1) {
+            for (const auto& r : ranges) {
+                if (r.target == t) emitRange(a, r);
+            }
+            continue;
+        }
+        ByteSet set{};
+        for (const auto& r : ranges) {
+            if (r.target == t) std::fill(set.begin() + r.lo, set.begin() + r.hi + 1, 1);
+        }
+        a.emit({0x80, 0xBC, 0x02});                      // cmp byte [rdx + rax + table], 0
+        a.imm32(static_cast<uint32_t>(tables.offsetOf(set)));
+        a.emit({0x00});
+        a.jump(JNE, t);
+    }
+    a.jump(JMP, fallback);
+    return true;
+}
+
+}  // namespace
+#endif
+
+DFAJit::~DFAJit() {
+#ifdef DFA_JIT_X86_64
+    if (code) munmap(code, mapped);
+#endif
+}
+
+bool DFAJit::available() {
+#ifdef DFA_JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DFAJit::compile(const CompiledDFA& dfa) {
+    if (function) return true;
+#ifdef DFA_JIT_X86_64
+    int rowCount = dfa.stateCount();
+    Assembler a;
+    for (int row = 0; row < rowCount; row++) a.newLabel();
+    int acceptLabel = a.newLabel();
+    int dataLabel = a.newLabel();
+    SetTables tables;
+
+    a.emit({0x48, 0x8D, 0x15});                          // lea rdx, [rip + data]
+    a.rel32(dataLabel);
+    a.jump(JMP, dfa.start >> dfa.strideShift);
+    for (int row = 1; row < rowCount; row++) {
+        int32_t id = row << dfa.strideShift;
+        a.bind(row);
+        if (dfa.isAccelerated(id) && dfa.accels[row - 1].kind == DFAAccel::ESCAPE_BYTES &&
+            dfa.accels[row - 1].count == 0) {
+            a.jump(JMP, dfa.isAccepting(id) ? acceptLabel : 0);  // Never leaves: the rest of the input is consumed
+            continue;
+        }
+        a.emit({0x48, 0x39, 0xF7});                      // cmp rdi, rsi
+        a.jump(JE, dfa.isAccepting(id) ? acceptLabel : 0);
+        a.emit({0x0F, 0xB6, 0x07});                      // movzx eax, byte [rdi]
+        a.emit({0x48, 0xFF, 0xC7});                      // inc rdi
+        if (!emitTransitions(a, tables, stateRanges(dfa, row), rowCount)) return false;
+        if (a.code.size() + tables.bytes.size() > MAX_CODE) return false;
+    }
+    a.bind(0);
+    a.emit({0x31, 0xC0, 0xC3});                          // xor eax, eax ; ret
+    a.bind(acceptLabel);
+    a.emit({0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3});        // mov eax, 1 ; ret
+    while (a.code.size() % 64 != 0) a.emit({0xCC});      // int3 padding up to the tables
+    a.bind(dataLabel);
+    a.code.insert(a.code.end(), tables.bytes.begin(), tables.bytes.end());
+    a.patch();
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t length = (a.code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    std::memcpy(memory, a.code.data(), a.code.size());
+    if (mprotect(memory, length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, length);
+        return false;
+    }
+
+    code = memory;
+    mapped = length;
+    size = a.code.size();
+    function = reinterpret_cast<MatchFunction>(memory);
+    return true;
+#else
+    (void)dfa;
+    return false;
+#endif
+}
+
+HotDFA::HotDFA(CompiledDFA table, uint64_t threshold) : compiled(std::move(table)), threshold(threshold) {}
+
+bool HotDFA::matches(const char* data, size_t size) const {
+    DFAJit::MatchFunction function = entry.load(std::memory_order_acquire);
+    if (!function && compiled.sheng.empty() && calls.load(std::memory_order_relaxed) <= threshold &&
+        calls.fetch_add(1, std::memory_order_relaxed) == threshold && jit.compile(compiled)) {
+        function = jit.entry();
+        entry.store(function, std::memory_order_release);
+    }
+    if (!function) return compiled.matches(data, size);
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return function(p, p + size) != 0;
+}
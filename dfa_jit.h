@@ -0,0 +1,109 @@
+#ifndef DFA_JIT_H
+#define DFA_JIT_H
+
+#include "compiled_dfa.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * FILE: dfa_jit.h
+ * DESCRIPTION: Native x86-64 code for hot compiled DFAs
+ * PROCESS:
+ *
+ *   A table DFA step is a load whose address depends on the previous load.
+ *   DFAJit turns each DFA state into a block of machine code instead, so the
+ *   state lives in the program counter:
+ *
+ *   1. Code shape (System V x86-64, int f(const unsigned char* p, end))
+ *      - One block per live state:
+ *            state_r:  cmp p, end ; je accept/reject (the state's verdict)
+ *                      movzx eax, byte [p] ; inc p
+ *                      one check per target, a direct jump to its block
+ *                      jmp state_fallback
+ *      - A target whose bytes form one range is a compare (lea + one
+ *        unsigned compare for an inner range); one with several ranges is
+ *        a test of a 256-byte membership table placed after the code. The
+ *        load is indexed by the input byte only, so unlike a table DFA no
+ *        load waits for the previous one
+ *      - The target covering the most bytes (usually the dead state) is the
+ *        fall-through; the others are checked, most bytes first
+ *      - The dead state is the shared reject block, and a state that never
+ *        leaves (.*) jumps straight to its verdict: no indirect jumps
+ *      - States with more than MAX_TARGETS checks, or code above MAX_CODE,
+ *        make compile() fail and the table stays in use
+ *      - Branches follow the data: fast when the input mostly stays on one
+ *        path (identifiers, reads, log lines), slow when every byte picks a
+ *        different target at random, which is where Sheng is better
+ *
+ *   2. Memory
+ *      - The code is written into an anonymous read/write mapping, then
+ *        switched to read/execute with mprotect (never writable and
+ *        executable at once); the destructor unmaps it
+ *      - Only built on x86-64 POSIX systems with ATFL_ENABLE_JIT (CMake);
+ *        elsewhere available() is false and compile() always fails
+ *
+ *   3. HotDFA: JIT only what is hot
+ *      - Wraps a CompiledDFA; the first JIT_THRESHOLD calls run on the
+ *        table, the next one compiles the code once and every later call
+ *        runs it
+ *      - Automata small enough for Sheng stay on Sheng: one shuffle per
+ *        byte beats a branch per byte
+ *      - Counting is one relaxed atomic add; exactly one caller sees the
+ *        threshold and compiles, then publishes the entry point with a
+ *        release store, so concurrent matchers are safe
+ *      - If compile() fails the table simply stays in use; past the
+ *        threshold the counter is only loaded, never incremented
+ */
+
+class DFAJit {
+public:
+    typedef int (*MatchFunction)(const unsigned char* p, const unsigned char* end);
+
+    static constexpr int MAX_TARGETS = 16;             // Checks per state, besides the fall-through
+    static constexpr size_t MAX_CODE = 1 << 20;        // Bytes of machine code
+
+    DFAJit() = default;
+    ~DFAJit();
+    DFAJit(const DFAJit&) = delete;
+    DFAJit& operator=(const DFAJit&) = delete;
+
+    static bool available();
+    bool compile(const CompiledDFA& dfa);
+    bool ready() const { return function != nullptr; }
+    MatchFunction entry() const { return function; }
+    size_t codeBytes() const { return size; }
+
+    bool matches(const char* data, size_t size) const {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        return function(p, p + size) != 0;
+    }
+
+private:
+    void* code = nullptr;
+    size_t mapped = 0;
+    size_t size = 0;
+    MatchFunction function = nullptr;
+};
+
+class HotDFA {
+public:
+    static constexpr uint64_t JIT_THRESHOLD = 1000;  // Calls on the table before compiling
+
+    explicit HotDFA(CompiledDFA table, uint64_t threshold = JIT_THRESHOLD);
+
+    bool matches(const char* data, size_t size) const;
+    bool matches(const std::string& input) const { return matches(input.data(), input.size()); }
+    bool jitted() const { return entry.load(std::memory_order_acquire) != nullptr; }
+    const CompiledDFA& table() const { return compiled; }
+
+private:
+    CompiledDFA compiled;
+    uint64_t threshold;
+    mutable DFAJit jit;
+    mutable std::atomic<uint64_t> calls{0};
+    mutable std::atomic<DFAJit::MatchFunction> entry{nullptr};
+};
+
+#endif
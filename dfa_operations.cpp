@@ -0,0 +1,347 @@
+#include "dfa_operations.h"
+#include <unordered_map>
+#include <queue>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+
+/**
+ * FILE: dfa_operations.cpp
+ * DESCRIPTION: Implementation of DFA minimization and boolean operations
+ * PROCESS:
+ *
+ *   minimizeDFA():
+ *   - Keep the states reachable from the start, add one sink state
+ *   - Reverse transitions are stored per (target, byte) in one flat array
+ *   - Partition kept as a permutation of states with [first, end) per block;
+ *     splitting moves the marked states to the front of their block
+ *   - Worklist of splitter blocks; for each byte, the predecessors of the
+ *     splitter refine every block they touch. After a split, the smaller
+ *     half is queued (Hopcroft's trick) -> O(256 * n log n)
+ *   - The sink's block becomes DEAD_STATE in the result
+ *
+ *   productDFA():
+ *   - Worklist over reachable pairs, keyed by (p + 1) * (|second| + 1) + (q + 1)
+ *   - accept(inFirst, inSecond) decides acceptance of a pair and which
+ *     pairs are dead: once a side is dead, the pair only survives if the
+ *     other side can still make accept() true
+ *
+ *   checkEquivalence():
+ *   - Element ids: first's states, first's sink, second's states, second's sink
+ *   - Pop (p, q): skip if find(p) == find(q); fail if acceptance differs;
+ *     otherwise union them and push the 256 successor pairs
+ *   - Every union merges two classes, so at most |a| + |b| + 1 pairs expand
+ *
+ *   shortestWitness():
+ *   - Plain BFS over pairs with parent links; the first pair for which
+ *     differs(p accepts, q accepts) holds spells the shortest counterexample
+ */
+
+DFA minimizeDFA(const DFA& dfa) {
+    // Reachable states, renumbered; index n is the sink
+    std::vector<int> index(dfa.stateCount(), -1);
+    std::vector<int> order;
+    std::queue<int> work;
+    index[dfa.start] = 0;
+    order.push_back(dfa.start);
+    work.push(dfa.start);
+    while (!work.empty()) {
+        int s = work.front(); work.pop();
+        for (int c = 0; c < 256; c++) {
+            int t = dfa.next(s, static_cast<unsigned char>(c));
+            if (t != DFA::DEAD_STATE && index[t] < 0) {
+                index[t] = static_cast<int>(order.size());
+                order.push_back(t);
+                work.push(t);
+            }
+        }
+    }
+
+    int n = static_cast<int>(order.size());
+    int total = n + 1;
+    auto target = [&](int s, int c) {
+        if (s == n) return n;
+        int t = dfa.next(order[s], static_cast<unsigned char>(c));
+        return t == DFA::DEAD_STATE ? n : index[t];
+    };
+    auto tagOf = [&](int s) { return s == n ? -1 : dfa.acceptTag[order[s]]; };
+
+    // Reverse transitions: preds[predStart[t * 256 + c] .. predStart[t * 256 + c + 1])
+    std::vector<int> predStart(static_cast<size_t>(total) * 256 + 1, 0);
+    for (int s = 0; s < total; s++) {
+        for (int c = 0; c < 256; c++) predStart[target(s, c) * 256 + c + 1]++;
+    }
+    for (size_t k = 1; k < predStart.size(); k++) predStart[k] += predStart[k - 1];
+    std::vector<int> preds(predStart.back());
+    std::vector<int> fill(predStart.begin(), predStart.end() - 1);
+    for (int s = 0; s < total; s++) {
+        for (int c = 0; c < 256; c++) preds[fill[target(s, c) * 256 + c]++] = s;
+    }
+
+    // Initial partition by accept tag
+    std::vector<int> elems(total), pos(total), blockOf(total);
+    std::vector<int> first, end, marked;
+    std::unordered_map<int, int> tagBlock;
+    std::vector<std::vector<int>> initial;
+    for (int s = 0; s < total; s++) {
+        auto it = tagBlock.find(tagOf(s));
+        if (it == tagBlock.end()) {
+            it = tagBlock.emplace(tagOf(s), static_cast<int>(initial.size())).first;
+            initial.emplace_back();
+        }
+        initial[it->second].push_back(s);
+    }
+    int cursor = 0;
+    for (size_t b = 0; b < initial.size(); b++) {
+        first.push_back(cursor);
+        for (int s : initial[b]) {
+            elems[cursor] = s;
+            pos[s] = cursor++;
+            blockOf[s] = static_cast<int>(b);
+        }
+        end.push_back(cursor);
+        marked.push_back(0);
+    }
+
+    std::vector<int> worklist;
+    std::vector<bool> queued(first.size(), true);
+    for (size_t b = 0; b < first.size(); b++) worklist.push_back(static_cast<int>(b));
+
+    std::vector<int> splitter, touched;
+    while (!worklist.empty()) {
+        int b = worklist.back(); worklist.pop_back();
+        queued[b] = false;
+        splitter.assign(elems.begin() + first[b], elems.begin() + end[b]);
+
+        for (int c = 0; c < 256; c++) {
+            touched.clear();
+            for (int t : splitter) {
+                for (int k = predStart[t * 256 + c]; k < predStart[t * 256 + c + 1]; k++) {
+                    int s = preds[k];
+                    int block = blockOf[s];
+                    if (marked[block] == 0) touched.push_back(block);
+                    int swapPos = first[block] + marked[block]++;
+                    int other = elems[swapPos];
+                    std::swap(elems[pos[s]], elems[swapPos]);
+                    pos[other] = pos[s];
+                    pos[s] = swapPos;
+                }
+            }
+
+            for (int block : touched) {
+                int count = marked[block];
+                marked[block] = 0;
+                if (count == end[block] - first[block]) continue;
+
+                // Marked prefix becomes a new block
+                int fresh = static_cast<int>(first.size());
+                first.push_back(first[block]);
+                end.push_back(first[block] + count);
+                marked.push_back(0);
+                first[block] += count;
+                for (int k = first[fresh]; k < end[fresh]; k++) blockOf[elems[k]] = fresh;
+
+                if (queued[block]) {
+                    queued.push_back(true);
+                    worklist.push_back(fresh);
+                } else {
+                    int smaller = (count <= end[block] - first[block]) ? fresh : block;
+                    queued.push_back(smaller == fresh);
+                    queued[smaller] = true;
+                    worklist.push_back(smaller);
+                }
+            }
+        }
+    }
+
+    // Renumber blocks in BFS order from the start; the sink block is dead
+    int sinkBlock = blockOf[n];
+    DFA result;
+    std::vector<int> blockId(first.size(), -1);
+    std::vector<int> blocks;
+    if (blockOf[0] == sinkBlock) {
+        result.acceptTag.push_back(-1);
+        result.transitions.assign(256, DFA::DEAD_STATE);
+        return result;
+    }
+    blockId[blockOf[0]] = 0;
+    blocks.push_back(blockOf[0]);
+    for (size_t k = 0; k < blocks.size(); k++) {
+        int rep = elems[first[blocks[k]]];
+        result.acceptTag.push_back(tagOf(rep));
+        for (int c = 0; c < 256; c++) {
+            int tb = blockOf[target(rep, c)];
+            int id = DFA::DEAD_STATE;
+            if (tb != sinkBlock) {
+                if (blockId[tb] < 0) {
+                    blockId[tb] = static_cast<int>(blocks.size());
+                    blocks.push_back(tb);
+                }
+                id = blockId[tb];
+            }
+            result.transitions.push_back(id);
+        }
+    }
+    return result;
+}
+
+template <typename Accept>
+static DFA productDFA(const DFA& a, const DFA& b, Accept accept) {
+    DFA product;
+    long long width = b.stateCount() + 1;
+    std::unordered_map<long long, int> ids;
+    std::vector<std::pair<int, int>> pairs;
+
+    auto alive = [&](int p, int q) {
+        if (p == DFA::DEAD_STATE && q == DFA::DEAD_STATE) return false;
+        if (p == DFA::DEAD_STATE) return accept(false, true) || accept(false, false);
+        if (q == DFA::DEAD_STATE) return accept(true, false) || accept(false, false);
+        return true;
+    };
+    auto addState = [&](int p, int q) {
+        long long key = (p + 1) * width + (q + 1);
+        auto it = ids.find(key);
+        if (it != ids.end()) return it->second;
+
+        int id = product.stateCount();
+        ids[key] = id;
+        pairs.push_back({p, q});
+        bool inA = p != DFA::DEAD_STATE && a.isAccepting(p);
+        bool inB = q != DFA::DEAD_STATE && b.isAccepting(q);
+        product.acceptTag.push_back(accept(inA, inB) ? 0 : -1);
+        product.transitions.resize(product.transitions.size() + 256, DFA::DEAD_STATE);
+        return id;
+    };
+
+    product.start = addState(a.start, b.start);
+    for (int current = 0; current < product.stateCount(); current++) {
+        auto [p, q] = pairs[current];
+        for (int c = 0; c < 256; c++) {
+            int np = (p == DFA::DEAD_STATE) ? p : a.next(p, static_cast<unsigned char>(c));
+            int nq = (q == DFA::DEAD_STATE) ? q : b.next(q, static_cast<unsigned char>(c));
+            if (!alive(np, nq)) continue;
+            int target = addState(np, nq);
+            product.transitions[current * 256 + c] = target;
+        }
+    }
+
+    return minimizeDFA(product);
+}
+
+DFA intersectDFA(const DFA& first, const DFA& second) {
+    return productDFA(first, second, [](bool x, bool y) { return x && y; });
+}
+
+DFA unionDFA(const DFA& first, const DFA& second) {
+    return productDFA(first, second, [](bool x, bool y) { return x || y; });
+}
+
+DFA differenceDFA(const DFA& first, const DFA& second) {
+    return productDFA(first, second, [](bool x, bool y) { return x && !y; });
+}
+
+DFA complementDFA(const DFA& dfa) {
+    DFA complete = dfa;
+    int sink = complete.stateCount();
+    complete.acceptTag.push_back(-1);
+    complete.transitions.resize(complete.transitions.size() + 256, DFA::DEAD_STATE);
+
+    for (auto& t : complete.transitions) {
+        if (t == DFA::DEAD_STATE) t = sink;
+    }
+    for (auto& tag : complete.acceptTag) tag = (tag >= 0) ? -1 : 0;
+
+    return minimizeDFA(complete);
+}
+
+// Shortest string leading (first.start, second.start) to a pair where differs(), or holds = true
+template <typename Differs>
+static LanguageCheck shortestWitness(const DFA& a, const DFA& b, Differs differs, bool pruneDeadFirst) {
+    long long width = b.stateCount() + 1;
+    std::unordered_map<long long, int> ids;
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<int> parent;
+    std::vector<unsigned char> via;
+
+    auto visit = [&](int p, int q, int from, int c) {
+        long long key = (p + 1) * width + (q + 1);
+        if (!ids.emplace(key, static_cast<int>(pairs.size())).second) return;
+        pairs.push_back({p, q});
+        parent.push_back(from);
+        via.push_back(static_cast<unsigned char>(c));
+    };
+
+    LanguageCheck result;
+    visit(a.start, b.start, -1, 0);
+    for (size_t current = 0; current < pairs.size(); current++) {
+        auto [p, q] = pairs[current];
+        bool inA = p != DFA::DEAD_STATE && a.isAccepting(p);
+        bool inB = q != DFA::DEAD_STATE && b.isAccepting(q);
+        if (differs(inA, inB)) {
+            result.holds = false;
+            for (int k = static_cast<int>(current); parent[k] >= 0; k = parent[k]) {
+                result.counterexample += static_cast<char>(via[k]);
+            }
+            std::reverse(result.counterexample.begin(), result.counterexample.end());
+            return result;
+        }
+
+        for (int c = 0; c < 256; c++) {
+            int np = (p == DFA::DEAD_STATE) ? p : a.next(p, static_cast<unsigned char>(c));
+            int nq = (q == DFA::DEAD_STATE) ? q : b.next(q, static_cast<unsigned char>(c));
+            if (np == DFA::DEAD_STATE && (pruneDeadFirst || nq == DFA::DEAD_STATE)) continue;
+            visit(np, nq, static_cast<int>(current), c);
+        }
+    }
+    return result;
+}
+
+LanguageCheck checkEquivalence(const DFA& first, const DFA& second) {
+    int firstSink = first.stateCount();
+    int offset = firstSink + 1;
+    int secondSink = offset + second.stateCount();
+
+    std::vector<int> classOf(secondSink + 1);
+    std::iota(classOf.begin(), classOf.end(), 0);
+    auto find = [&](int x) {
+        while (classOf[x] != x) {
+            classOf[x] = classOf[classOf[x]];
+            x = classOf[x];
+        }
+        return x;
+    };
+    auto idA = [&](int p) { return p == DFA::DEAD_STATE ? firstSink : p; };
+    auto idB = [&](int q) { return q == DFA::DEAD_STATE ? secondSink : offset + q; };
+
+    std::queue<std::pair<int, int>> work;
+    work.push({first.start, second.start});
+    bool equivalent = true;
+
+    while (!work.empty() && equivalent) {
+        auto [p, q] = work.front(); work.pop();
+        int rootA = find(idA(p));
+        int rootB = find(idB(q));
+        if (rootA == rootB) continue;
+
+        bool inA = p != DFA::DEAD_STATE && first.isAccepting(p);
+        bool inB = q != DFA::DEAD_STATE && second.isAccepting(q);
+        if (inA != inB) {
+            equivalent = false;
+            break;
+        }
+        classOf[rootA] = rootB;
+
+        for (int c = 0; c < 256; c++) {
+            int np = (p == DFA::DEAD_STATE) ? p : first.next(p, static_cast<unsigned char>(c));
+            int nq = (q == DFA::DEAD_STATE) ? q : second.next(q, static_cast<unsigned char>(c));
+            work.push({np, nq});
+        }
+    }
+
+    if (equivalent) return LanguageCheck();
+    return shortestWitness(first, second, [](bool x, bool y) { return x != y; }, false);
+}
+
+LanguageCheck checkInclusion(const DFA& first, const DFA& second) {
+    return shortestWitness(first, second, [](bool x, bool y) { return x && !y; }, true);
+}
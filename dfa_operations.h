@@ -0,0 +1,62 @@
+#ifndef DFA_OPERATIONS_H
+#define DFA_OPERATIONS_H
+
+#include "dfa_construction.h"
+#include <string>
+
+/**
+ * FILE: dfa_operations.h
+ * DESCRIPTION: Language-level operations on compiled DFAs
+ * PROCESS:
+ *
+ *   Thompson's construction gives union, concatenation and star on NFAs;
+ *   intersection and complement need deterministic automata, so these
+ *   operations take and return DFAs.
+ *
+ *   1. minimizeDFA(dfa) - Hopcroft partition refinement
+ *      - Initial partition: states grouped by acceptTag (lexer tags survive)
+ *      - The implicit dead state takes part as an explicit sink, so states
+ *        that can never accept collapse into DEAD_STATE
+ *      - Unreachable states are dropped; states are renumbered in BFS order
+ *        from the start, so equal languages give identical tables
+ *
+ *   2. Product construction: intersectDFA, unionDFA, differenceDFA
+ *      - States are pairs (p, q) with DEAD_STATE standing for the sink
+ *      - Built lazily: only pairs reachable from (start, start) are created,
+ *        and pairs that can no longer accept (e.g. (p, dead) for an
+ *        intersection) are not expanded at all
+ *      - The result accepts with tag 0 and is minimized
+ *
+ *   3. complementDFA(dfa)
+ *      - Completes the table with a sink and flips acceptance
+ *      - Complement is over all byte strings (for UTF-8 automata this includes
+ *        invalid sequences)
+ *
+ *   4. checkEquivalence(a, b) / checkInclusion(a, b)
+ *      - Equivalence: Hopcroft-Karp. Union-find over the states of both
+ *        automata (plus their sinks); a pair already in one class is
+ *        equivalent up to congruence and is not explored again, so the check
+ *        is near-linear in |a| + |b| instead of |a| * |b|
+ *      - Inclusion L(a) ⊆ L(b): BFS over reachable pairs, pruning pairs whose
+ *        first side is dead (nothing left to include)
+ *      - On failure, a BFS over pairs returns a SHORTEST counterexample:
+ *        accepted by exactly one side (equivalence) or by a but not b (inclusion)
+ *
+ *   Combining filter rules: differenceDFA(intersectDFA(a, b), c) is one
+ *   automaton that runs in a single pass instead of three matchers.
+ */
+
+struct LanguageCheck {
+    bool holds = true;
+    std::string counterexample;  // Shortest witness when !holds
+};
+
+DFA minimizeDFA(const DFA& dfa);
+DFA intersectDFA(const DFA& first, const DFA& second);
+DFA unionDFA(const DFA& first, const DFA& second);
+DFA differenceDFA(const DFA& first, const DFA& second);
+DFA complementDFA(const DFA& dfa);
+LanguageCheck checkEquivalence(const DFA& first, const DFA& second);
+LanguageCheck checkInclusion(const DFA& first, const DFA& second);
+
+#endif
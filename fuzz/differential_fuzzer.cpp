@@ -0,0 +1,282 @@
+/**
+ * FILE: fuzz/differential_fuzzer.cpp
+ * DESCRIPTION: Differential fuzzing harness across all matching engines
+ * PROCESS:
+ *
+ *   Input layout (libFuzzer corpus files use the same layout):
+ *     byte 0          = pattern length L
+ *     bytes 1 .. L    = raw pattern (user syntax, fed to preprocessRegex)
+ *     bytes L+1 ..    = subject string
+ *
+ *   For each input:
+ *   1. preprocessRegex -> toPostfix -> isValidPostfix; malformed patterns are
+ *      skipped (regexToNFA would terminate the process)
+ *   2. Resource limits: pattern, subject, repetition bounds and DFA states
+ *      are capped; inputs over a limit are counted, not compared
+ *   3. Every engine answers "does the pattern match the whole subject?":
+ *      - simulateNFA           (NFA state lists; configuration sets with
+ *                               counters)
+ *      - simulateCountingNFA   (counting sets, or its fallback)
+ *      - DFA::matches          (subset construction)
+ *      - minimizeDFA + matches (Hopcroft-minimized table)
+ *      - CompiledDFA::matches  (premultiplied layout of the minimized DFA,
+ *                               Sheng engine when it fits)
+ *      - the same CompiledDFA with Sheng disabled (table only)
+ *      - the table row-compressed (compileDFA(minimal, 0)), Sheng disabled
+ *      - DFAJit native code of the compiled DFA (x86-64 builds only)
+ *      - DerivativeMatcher     (lazy DFA of Brzozowski derivatives, no NFA)
+ *      - the minimized DFA behind the analyzePattern() prefilter, so a
+ *        prefilter that rejects a match shows up as a disagreement
+ *      - PatternMatcher, BATCH and ONE_SHOT, plus a ONE_SHOT matcher
+ *        limited to 2 derivative states, so the DERIVATIVE -> COUNTING/NFA
+ *        fallback runs on almost every subject
+ *   4. Maximal munch: CompiledDFA::longestMatch (the accelerated scan
+ *      Lexer::next uses) on the compiled, table and row-compressed layouts
+ *      must find the longest non-empty prefix the NFA accepts
+ *   5. --utf8: the code-point NFA (makeCodePointClass) against its
+ *      counting-set engine, DFA, minimized and compiled DFA and the UTF-8
+ *      PatternMatcher in both workloads; on ASCII subjects the byte NFA
+ *      must agree too. Random patterns and subjects include multi-byte
+ *      characters and an invalid 0xFF byte
+ *   6. The subject alone is usually rejected, so strings sampled by
+ *      StringGenerator from the byte and UTF-8 DFAs are checked too (must
+ *      be accepted by all)
+ *   7. Any disagreement prints pattern, postfix and subject, then aborts so
+ *      libFuzzer records the crashing input
+ *
+ *   Build:
+ *     libFuzzer:  clang++ -std=c++17 -fsanitize=fuzzer,address ... (no main)
+ *     Standalone: define FUZZ_STANDALONE; runs random patterns from a seed,
+ *                 or replays the corpus files given on the command line
+ */
+
+#include "../nfa_state.h"
+#include "../regex_preprocessor.h"
+#include "../thompsons_construction.h"
+#include "../nfa_simulator.h"
+#include "../counting_set_automaton.h"
+#include "../dfa_construction.h"
+#include "../dfa_operations.h"
+#include "../compiled_dfa.h"
+#include "../dfa_jit.h"
+#include "../derivative_matcher.h"
+#include "../pattern_analysis.h"
+#include "../match_planner.h"
+#include "../string_generator.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+static const size_t MAX_PATTERN = 48;
+static const size_t MAX_SUBJECT = 256;
+static const int MAX_REPEAT = 32;
+static const size_t MAX_DFA_STATES = 4096;
+
+static size_t overLimit = 0;
+static size_t compared = 0;
+
+static bool repeatsWithinLimit(const std::string& postfix) {
+    for (size_t i = 0; i < postfix.length(); ) {
+        size_t end = regexTokenEnd(postfix, i);
+        int min, max;
+        if (postfix[i] == '{' && parseRepeat(postfix.substr(i, end - i), min, max)) {
+            if (min > MAX_REPEAT || max > MAX_REPEAT) return false;
+        }
+        i = end;
+    }
+    return true;
+}
+
+struct Verdict {
+    const char* engine;
+    bool accepted;
+};
+
+static void report(const char* what, const std::string& pattern, const std::string& postfix,
+                   const std::string& subject, const std::vector<Verdict>& verdicts) {
+    std::cerr << "DISAGREEMENT (" << what << ")\n"
+              << "  pattern: " << pattern << "\n"
+              << "  postfix: " << postfix << "\n"
+              << "  subject: " << subject << " (" << subject.size() << " bytes)\n ";
+    for (const auto& v : verdicts) std::cerr << " " << v.engine << "=" << v.accepted;
+    std::cerr << std::endl;
+    abort();
+}
+
+static void compareEngines(const std::string& pattern, const std::string& subject) {
+    if (pattern.empty() || pattern.size() > MAX_PATTERN || subject.size() > MAX_SUBJECT) {
+        overLimit++;
+        return;
+    }
+
+    std::string postfix = toPostfix(preprocessRegex(pattern));
+    if (!isValidPostfix(postfix)) return;
+    if (!repeatsWithinLimit(postfix)) {
+        overLimit++;
+        return;
+    }
+
+    NFAFragment nfa = regexToNFA(postfix);
+    CountingNFA counting = buildCountingNFA(nfa);
+    NFAFragment nfa8 = regexToNFA(postfix, true);
+    DFA dfa, dfa8;
+    try {
+        dfa = buildDFA(nfa, MAX_DFA_STATES);
+        dfa8 = buildDFA(nfa8, MAX_DFA_STATES);
+    } catch (const std::runtime_error&) {
+        overLimit++;
+        StateManager::clear();
+        return;
+    }
+    DFA minimal = minimizeDFA(dfa);
+    CompiledDFA compiled = compileDFA(minimal);
+    CompiledDFA table = compiled;
+    table.sheng = ShengDFA();
+    CompiledDFA packed = compileDFA(minimal, 0);
+    packed.sheng = ShengDFA();
+    DFAJit jit;
+    jit.compile(compiled);
+    DerivativeMatcher derivative(postfix, MAX_DFA_STATES);
+    PatternAnalysis analysis = analyzePattern(postfix);
+    PatternMatcher batch(pattern, MatchWorkload::BATCH);
+    PatternMatcher oneShot(pattern, MatchWorkload::ONE_SHOT);
+    PatternMatcher fallback(pattern, MatchWorkload::ONE_SHOT, false, 2);
+
+    CountingNFA counting8 = buildCountingNFA(nfa8);
+    DFA minimal8 = minimizeDFA(dfa8);
+    CompiledDFA compiled8 = compileDFA(minimal8);
+    PatternMatcher batch8(pattern, MatchWorkload::BATCH, true);
+    PatternMatcher oneShot8(pattern, MatchWorkload::ONE_SHOT, true);
+
+    auto check = [&](const char* what, const std::string& input, bool mustAccept) {
+        std::vector<Verdict> verdicts = {
+            {"nfa", simulateNFA(nfa, input)},
+            {"counting", simulateCountingNFA(counting, input)},
+            {"dfa", dfa.matches(input)},
+            {"minimized", minimal.matches(input)},
+            {"compiled", compiled.matches(input)},
+            {"table", table.matches(input)},
+            {"row-compressed", packed.matches(input)},
+            {"prefilter", analysis.mayMatch(input.data(), input.size()) && minimal.matches(input)},
+            {"planner-batch", batch.matches(input)},
+            {"planner-one-shot", oneShot.matches(input)},
+            {"planner-fallback", fallback.matches(input)},
+        };
+        if (jit.ready()) verdicts.push_back({"jit", jit.matches(input.data(), input.size())});
+        try {
+            verdicts.push_back({"derivative", derivative.matches(input)});
+        } catch (const std::runtime_error&) {
+            overLimit++;
+        }
+        bool disagree = mustAccept && !verdicts[0].accepted;
+        for (const auto& v : verdicts) disagree = disagree || v.accepted != verdicts[0].accepted;
+        if (disagree) report(what, pattern, postfix, input, verdicts);
+    };
+
+    // Maximal munch: the longest non-empty prefix the NFA accepts, as Lexer::next finds it
+    auto checkLongest = [&](const std::string& input) {
+        size_t expected = input.size();
+        while (expected > 0 && !simulateNFA(nfa, input.data(), expected)) expected--;
+        for (const CompiledDFA* layout : {&compiled, &table, &packed}) {
+            int tag = -2;
+            size_t found = layout->longestMatch(input.data(), input.size(), tag);
+            if (found != expected || (tag == 0) != (expected > 0)) {
+                report("longest match", pattern, postfix, input,
+                       {{"nfa-prefix", expected > 0}, {"longestMatch", found == expected && tag == 0}});
+            }
+        }
+    };
+
+    // --utf8: every engine against the code-point NFA; on ASCII input a code
+    // point is a byte, so the byte NFA must agree as well
+    auto checkUtf8 = [&](const char* what, const std::string& input, bool mustAccept) {
+        std::vector<Verdict> verdicts = {
+            {"nfa-utf8", simulateNFA(nfa8, input)},
+            {"counting-utf8", simulateCountingNFA(counting8, input)},
+            {"dfa-utf8", dfa8.matches(input)},
+            {"minimized-utf8", minimal8.matches(input)},
+            {"compiled-utf8", compiled8.matches(input)},
+            {"planner-batch-utf8", batch8.matches(input)},
+            {"planner-one-shot-utf8", oneShot8.matches(input)},
+        };
+        bool ascii = true;
+        for (char c : input) ascii = ascii && static_cast<unsigned char>(c) < 0x80;
+        if (ascii) verdicts.push_back({"nfa", simulateNFA(nfa, input)});
+        bool disagree = mustAccept && !verdicts[0].accepted;
+        for (const auto& v : verdicts) disagree = disagree || v.accepted != verdicts[0].accepted;
+        if (disagree) report(what, pattern, postfix, input, verdicts);
+    };
+
+    check("subject", subject, false);
+    checkLongest(subject);
+    checkUtf8("utf8 subject", subject, false);
+
+    StringGenerator generator(dfa, 16, subject.size());
+    std::string accepted;
+    if (generator.sample(static_cast<int>(subject.size() % 17), accepted)) {
+        check("generated", accepted, true);
+        checkLongest(accepted + subject);
+    }
+    StringGenerator generator8(dfa8, 16, subject.size());
+    if (generator8.sample(static_cast<int>(subject.size() % 17), accepted)) {
+        checkUtf8("utf8 generated", accepted, true);
+    }
+
+    compared++;
+    StateManager::clear();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) return 0;
+    size_t patternLength = data[0];
+    if (patternLength + 1 > size) return 0;
+
+    std::string pattern(reinterpret_cast<const char*>(data + 1), patternLength);
+    std::string subject(reinterpret_cast<const char*>(data + 1 + patternLength), size - 1 - patternLength);
+    compareEngines(pattern, subject);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+#include <fstream>
+#include <iterator>
+#include <random>
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) != "--random") {
+        // Replay corpus files
+        for (int k = 1; k < argc; k++) {
+            std::ifstream file(argv[k], std::ios::binary);
+            std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+        }
+    } else {
+        // Random patterns over a small regex alphabet, random subjects over its literals
+        size_t iterations = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 20000;
+        std::mt19937_64 rng(argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1);
+        // Multi-byte pieces exercise the --utf8 code-point classes; 0xFF is never valid UTF-8
+        const std::vector<std::string> patternPieces = {"a", "b", "(", ")", "|", "*", "+", "?", ".", "{", "}", ",",
+                                                        "0", "1", "2", "3", "[", "]", "^", "-", "\\", "d",
+                                                        "\xC3\xA9", "\xCE\xBB", "\xE6\x97\xA5"};
+        const std::vector<std::string> subjectPieces = {"a", "b", "0", "1", "-", "\xC3\xA9", "\xCE\xBB",
+                                                        "\xE6\x97\xA5", "\xFF"};
+        for (size_t n = 0; n < iterations; n++) {
+            std::string pattern, subject;
+            size_t patternLength = 1 + rng() % 12;
+            for (size_t k = 0; k < patternLength; k++) pattern += patternPieces[rng() % patternPieces.size()];
+            size_t subjectLength = rng() % 10;
+            for (size_t k = 0; k < subjectLength; k++) {
+                // Mostly ASCII, so the byte and code-point NFAs are compared often
+                subject += subjectPieces[(rng() % 4 == 0) ? rng() % subjectPieces.size() : rng() % 5];
+            }
+            compareEngines(pattern, subject);
+        }
+    }
+
+    std::cout << "Compared " << compared << " patterns, " << overLimit << " over resource limits, 0 disagreements" << std::endl;
+    return 0;
+}
+#endif
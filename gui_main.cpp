@@ -4,6 +4,7 @@
 #include <vector>
 #include <deque>
 #include <set>
+#include <cstdlib>
 
 #include "adaptive_pda.h"
 #include "nfa_simulator.h"
@@ -122,7 +123,7 @@ static std::string runPhase1(const std::string& regex, const std::string& testIn
         // Step 2: Preprocessing
         oss << "[2] Character Class Expansion & Preprocessing:\n";
         oss << "    " << processed << "\n";
-        oss << "    (Character classes expanded to unions)\n\n";
+        oss << "    (Classes kept compact, '.' = explicit concatenation)\n\n";
         
         // Step 3: Postfix
         oss << "[3] Postfix Notation (RPN):\n";
@@ -156,11 +157,21 @@ static std::string runPhase1(const std::string& regex, const std::string& testIn
             NFAState* current = queue.front();
             queue.pop_front();
             
+            for (NFAState* next : current->epsilon) {
+                if (visited.find(next) == visited.end()) {
+                    oss << "      q" << current->id << " --[e]--> q" << next->id << "\n";
+                    visited.insert(next);
+                    queue.push_back(next);
+                    pathCount++;
+                    if (pathCount >= 5) break;
+                }
+            }
+            if (pathCount >= 5) break;
+
             for (const auto& [ch, nexts] : current->transitions) {
                 for (NFAState* next : nexts) {
                     if (visited.find(next) == visited.end()) {
-                        std::string display = (ch == 'E') ? "e" : std::string(1, ch);
-                        oss << "      q" << current->id << " --[" << display << "]--> q" << next->id << "\n";
+                        oss << "      q" << current->id << " --[" << ch << "]--> q" << next->id << "\n";
                         visited.insert(next);
                         queue.push_back(next);
                         pathCount++;
@@ -291,13 +302,32 @@ static std::string runPDA(const std::string& input) {
     return oss.str();
 }
 
+// ATFL_FONT overrides; otherwise the first system font found is used
+static bool loadFont(sf::Font& font) {
+    std::vector<std::string> candidates;
+    if (const char* custom = std::getenv("ATFL_FONT")) candidates.push_back(custom);
+    candidates.insert(candidates.end(), {
+        "C:/Windows/Fonts/arial.ttf",
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/TTF/DejaVuSans.ttf",
+        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+        "/System/Library/Fonts/Supplemental/Arial.ttf",
+        "/Library/Fonts/Arial.ttf",
+    });
+    for (const auto& path : candidates) {
+        if (font.openFromFile(path)) return true;
+    }
+    return false;
+}
+
 int main() {
     sf::RenderWindow window(sf::VideoMode({1100u, 700u}), "Formal Language Hierarchy - Lexical & Syntactic Analysis", sf::Style::Close);
     window.setFramerateLimit(60);
 
     sf::Font font;
-    if (!font.openFromFile("C:/Windows/Fonts/arial.ttf")) {
-        std::cerr << "Could not load font." << std::endl;
+    if (!loadFont(font)) {
+        std::cerr << "Could not load font (set ATFL_FONT to a .ttf file)." << std::endl;
     }
 
     // LEFT PANEL - CONTROLS
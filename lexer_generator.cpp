@@ -0,0 +1,78 @@
+#include "lexer_generator.h"
+#include "regex_preprocessor.h"
+#include "thompsons_construction.h"
+
+/**
+ * FILE: lexer_generator.cpp
+ * DESCRIPTION: Implementation of the multi-rule lexer generator
+ * PROCESS:
+ *
+ *   Lexer():
+ *   - Compile each rule regex to a Thompson NFA (same pipeline as Phase 1)
+ *   - subsetConstruction() merges the NFAs into one DFA; the tag of each
+ *     accept state is the lowest (highest priority) matching rule index
+ *   - The Lexer keeps only the DFA. The rule NFAs stay in StateManager, a
+ *     global pool other live fragments share, until the caller clears it
+ *   - compileDFA() builds the matching layout used by next()
+ *
+ *   next():
+ *   - CompiledDFA::longestMatch() scans forward from pos from the DFA start
+ *   - After each byte, one isSpecial() comparison: on a special state,
+ *     stop if it is the dead state; an accelerated state skips the run of
+ *     bytes it loops on in one scan; an accepting state records (end, tag)
+ *     at the end of that run
+ *   - Stop on the dead state or end of input
+ *   - Longest recorded match becomes the token (maximal munch)
+ *   - Empty matches are never emitted, so the scan always makes progress
+ *   - No match: one-byte error token (whole UTF-8 sequence in utf8 mode)
+ *   - Time: O(length of the longest prefix the DFA can follow)
+ */
+
+Lexer::Lexer(const std::vector<LexerRule>& rules, bool utf8) : rules(rules), utf8(utf8) {
+    std::vector<NFAFragment> nfas;
+    nfas.reserve(rules.size());
+    for (const auto& rule : rules) {
+        std::string postfix = toPostfix(preprocessRegex(rule.regex));
+        nfas.push_back(regexToNFA(postfix, utf8));
+    }
+    dfa = subsetConstruction(nfas);
+    compiled = compileDFA(dfa);
+}
+
+bool Lexer::next(const char* data, size_t size, size_t& pos, Token& token) const {
+    if (pos >= size) return false;
+
+    int bestTag = ERROR_TOKEN;
+    size_t bestEnd = pos + compiled.longestMatch(data + pos, size - pos, bestTag);
+
+    if (bestTag == ERROR_TOKEN) {
+        bestEnd = pos + (utf8 ? utf8SequenceLength(data + pos, size - pos) : 1);
+    }
+
+    token.id = bestTag;
+    token.offset = pos;
+    token.length = bestEnd - pos;
+    pos = bestEnd;
+    return true;
+}
+
+bool Lexer::next(const std::string& input, size_t& pos, Token& token) const {
+    return next(input.data(), input.size(), pos, token);
+}
+
+size_t Lexer::tokenize(const std::string& input, std::vector<Token>& out) const {
+    size_t pos = 0;
+    size_t count = 0;
+    Token token;
+    while (next(input, pos, token)) {
+        out.push_back(token);
+        count++;
+    }
+    return count;
+}
+
+const std::string& Lexer::tokenName(int id) const {
+    static const std::string errorName = "<error>";
+    if (id < 0 || id >= ruleCount()) return errorName;
+    return rules[id].name;
+}
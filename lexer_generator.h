@@ -0,0 +1,80 @@
+#ifndef LEXER_GENERATOR_H
+#define LEXER_GENERATOR_H
+
+#include "dfa_construction.h"
+#include "compiled_dfa.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * FILE: lexer_generator.h
+ * DESCRIPTION: Multi-rule lexer generator with maximal-munch tokenization
+ * PROCESS:
+ *
+ *   1. LexerRule: (token name, regex) pair
+ *      - Rules are ordered: earlier rules win when two rules match the same
+ *        longest lexeme (keywords listed before identifiers)
+ *      - skip marks tokens (whitespace, comments) that consumers such as the
+ *        parser pipeline drop; the lexer itself still reports them
+ *
+ *   2. Token: (id, offset, length) triple
+ *      - id is the index of the matching rule, or Lexer::ERROR_TOKEN
+ *      - Plain value type: the lexeme is never copied out of the input
+ *
+ *   3. Lexer construction
+ *      - Every rule regex goes through preprocessRegex -> toPostfix -> regexToNFA
+ *      - utf8 = true compiles classes and '.' over UTF-8 code points; the DFA
+ *        still consumes bytes, and an unmatched character is reported as one
+ *        ERROR_TOKEN covering its whole UTF-8 sequence
+ *      - All rule NFAs are merged by subset construction into ONE DFA whose
+ *        accept states are tagged with the winning rule index
+ *      - The DFA is then compiled to the premultiplied layout (compiled_dfa.h)
+ *        that next() runs on
+ *
+ *   4. Tokenization (maximal munch, single pass)
+ *      - next(): Run the DFA from the current offset, remember the last
+ *        accepting position and tag, stop at the dead state; dead,
+ *        accelerated and accepting states share one ID-range check per byte,
+ *        and accelerated states (identifier tails, comments) jump to the
+ *        next byte that leaves them
+ *      - Emit the longest match; if no rule matches, emit a one-byte
+ *        ERROR_TOKEN and resume after it
+ *      - next() performs no allocation; tokenize() only appends to a
+ *        caller-owned vector
+ */
+
+struct LexerRule {
+    std::string name;
+    std::string regex;
+    bool skip = false;
+};
+
+struct Token {
+    int id;
+    size_t offset;
+    size_t length;
+};
+
+class Lexer {
+    std::vector<LexerRule> rules;
+    DFA dfa;
+    CompiledDFA compiled;
+    bool utf8;
+
+public:
+    static constexpr int ERROR_TOKEN = -1;
+
+    explicit Lexer(const std::vector<LexerRule>& rules, bool utf8 = false);
+
+    bool next(const char* data, size_t size, size_t& pos, Token& token) const;
+    bool next(const std::string& input, size_t& pos, Token& token) const;
+    size_t tokenize(const std::string& input, std::vector<Token>& out) const;
+
+    const std::string& tokenName(int id) const;
+    bool isSkipped(int id) const { return id >= 0 && id < ruleCount() && rules[id].skip; }
+    int ruleCount() const { return static_cast<int>(rules.size()); }
+    const DFA& automaton() const { return dfa; }
+};
+
+#endif
@@ -10,35 +10,100 @@
  *    - StateManager: Manages memory for NFA states using unique_ptr
  * 
  * 2. regex_preprocessor.h/cpp
- *    - preprocessRegex(): Two-pass preprocessing (expands '+', adds explicit '.')
+ *    - preprocessRegex(): Two-pass preprocessing (compact classes, native quantifiers, explicit '.')
  *    - toPostfix(): Shunting-yard algorithm (infix to postfix RPN)
  *    - precedence(): Helper for operator precedence
  *
  * 3. thompsons_construction.h/cpp
  *    - Thompson's Construction: Converts postfix regex to NFA
- *    - makeChar(), makeConcat(), makeUnion(), makeStar()
+ *    - makeChar(), makeClass(), makeConcat(), makeUnion(), makeStar()
+ *    - makePlus(), makeOptional(), makeRepeat() (counter-based {n,m})
  *    - regexToNFA(): Stack-based postfix expression evaluation
  *
  * 4. nfa_simulator.h/cpp
  *    - Subset Construction algorithm: NFA simulation
- *    - getEpsilonClosure(): Compute epsilon reachability (DFS)
+ *    - EpsilonClosure: Iterative ε-closure, generation-stamped visited marks
  *    - simulateNFA(): Input string matching on NFA
  *
+ * 5. counting_set_automaton.h/cpp
+ *    - CountingNFA: {n,m} over a single class kept as one counting set
+ *    - simulateCountingNFA(): Step cost independent of n and m
+ *
+ * 6. match_context.h/cpp
+ *    - MatchContext: Per-match scratch (active sets, closure stack, counting sets)
+ *    - ActiveStates: Bitset or Briggs-Torczon sparse set, chosen by occupancy
+ *    - PooledMatchContext: Thread-local pool, repeated calls never allocate
+ *
+ * 7. dfa_construction.h/cpp
+ *    - subsetConstruction(): Merges tagged NFAs into one table-driven DFA
+ *
+ * 8. compiled_dfa.h/cpp
+ *    - CompiledDFA: Premultiplied state IDs, byte classes, dead/accept ID ranges
+ *    - compileDFA(): Layout used by the lexer and the atfl CLI
+ *    - Accelerated states: memchr / SSE2 skip over self-loop runs
+ *    - 8/16/32-bit IDs; row-compressed (default + exceptions) large tables
+ *
+ * 9. sheng_dfa.h/cpp
+ *    - ShengDFA: <= 16 states, one PSHUFB shuffle per byte (runtime SSSE3 check)
+ *    - Picked by compileDFA() for small automata, table DFA otherwise
+ *
+ * 10. dfa_jit.h/cpp
+ *    - DFAJit: Native x86-64 code, one block per state, direct jumps (mmap)
+ *    - HotDFA: Table until JIT_THRESHOLD calls, then the native code
+ *
+ * 11. derivative_matcher.h/cpp
+ *    - DerivativeMatcher: Brzozowski derivatives of hash-consed regex terms
+ *    - Lazy DFA: states and edges built on first visit, no NFA
+ *
+ * 12. match_planner.h/cpp
+ *    - PatternMatcher: Picks literal / Sheng / table / JIT / derivative / counting-set / NFA
+ *    - plan(): The chosen engine and the reasons, matchAll() for batches
+ *
+ * 13. pattern_analysis.h/cpp
+ *    - analyzePattern(): Min/max length, first bytes, required bytes from the postfix
+ *    - mayMatch(): O(1) length / first-byte checks, memchr for required bytes
+ *
+ * 14. batch_dedup.h/cpp
+ *    - hashBytes(): XXH64
+ *    - BatchDedup: Each distinct batch input computed once, results scattered back
+ *
+ * 15. dfa_operations.h/cpp
+ *    - minimizeDFA(): Hopcroft partition refinement
+ *    - intersectDFA(), unionDFA(), differenceDFA(), complementDFA()
+ *    - checkEquivalence(), checkInclusion(): Shortest counterexample on failure
+ *
+ * 16. string_generator.h/cpp
+ *    - StringGenerator: Uniform sampling by DFA path counts
+ *    - enumerate() up to length k, nearMiss() one-edit rejects
+ *
+ * 17. lexer_generator.h/cpp
+ *    - Lexer: Ordered (name, regex) rules compiled into one DFA
+ *    - next()/tokenize(): Maximal-munch (id, offset, length) token stream
+ *
  * PHASE 2: SYNTACTIC ANALYSIS (LL(1) Parsing with Adaptive Repair)
  * =================================================================
- * 5. adaptive_pda.h/cpp
+ * 18. adaptive_pda.h/cpp
  *    - AdaptivePDA: Pushdown Automaton with heuristic error recovery
  *    - Grammar: DNA hairpin nesting (context-free)
  *    - Affinity Matrix: Bio-inspired token substitution heuristics
  *    - Adaptive Repair: Graceful error handling instead of hard failure
+ *    - parseAll(): Batch of byte inputs, optionally deduplicated
+ *
+ * 19. token_pipeline.h/cpp
+ *    - TokenRingBuffer: Bounded SPSC queue between lexer and parser
+ *    - runPipeline(): Lexer thread feeds AdaptivePDA::parse()
+ *
+ * 20. token_source.h/cpp
+ *    - TokenSource: peek/advance over symbol IDs with windowed refills
+ *    - Span, byte, memory-mapped file, stream and lexer backends
  *
  * ALGORITHMS BY PROCESS:
  * ======================
  * 1. Regular Expression Parsing
  *    - Input: Regex string "(A|G)+"
- *    - Preprocessing: Expand '+' -> "(A|G)(A|G)*"
- *                     Add explicit dots -> "(A|G).(A|G).*"
- *    - Postfix: "AG|AG|.*."
+ *    - Preprocessing: Tokenize classes/quantifiers -> "(A|G)+"
+ *                     Add explicit dots (none needed here)
+ *    - Postfix: "AG|+"
  *
  * 2. NFA Construction (Thompson's)
  *    - Input: Postfix expression
@@ -62,7 +127,11 @@
 #include "regex_preprocessor.h"
 #include "thompsons_construction.h"
 #include "nfa_simulator.h"
+#include "counting_set_automaton.h"
+#include "dfa_operations.h"
+#include "lexer_generator.h"
 #include "adaptive_pda.h"
+#include "token_pipeline.h"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -77,7 +146,6 @@ int main() {
     // --- PHASE 1 DEMO ---
     cout << "\n[PHASE 1] Robust Lexical Analysis" << endl;
    
-    // New Feature: Handling '+' operator in regex preprocessing
     string rawRegex = "(A|G)+";
     string processedRegex = preprocessRegex(rawRegex);
     string postfix = toPostfix(processedRegex);
@@ -93,7 +161,37 @@ int main() {
     cout << "Testing string '" << testStr << "': ";
     if(simulateNFA(nfa, testStr)) cout << "MATCH" << endl;
     else cout << "INVALID" << endl;
+
+    // Counting sets: one counter for all 451 lengths instead of 500 unrolled states
+    CountingNFA readNFA = buildCountingNFA(regexToNFA(toPostfix(preprocessRegex("[ACGT]{50,500}"))));
+    string read(120, 'A');
+    cout << "Read of length " << read.length() << " against [ACGT]{50,500}: "
+         << (simulateCountingNFA(readNFA, read) ? "MATCH" : "INVALID") << endl;
+
+    // Filter rules combined into one automaton: identifiers that are not keywords
+    DFA identifiers = differenceDFA(buildDFA(regexToNFA(toPostfix(preprocessRegex("[a-z][a-z0-9]*")))),
+                                    buildDFA(regexToNFA(toPostfix(preprocessRegex("if|while")))));
+    cout << "Identifier-but-not-keyword DFA (" << identifiers.stateCount() << " states): 'while' "
+         << (identifiers.matches("while") ? "MATCH" : "INVALID") << ", 'whilst' "
+         << (identifiers.matches("whilst") ? "MATCH" : "INVALID") << endl;
+
+    // A rewritten pattern is checked against the original before it replaces it
+    LanguageCheck rewrite = checkEquivalence(buildDFA(regexToNFA(toPostfix(preprocessRegex("(A|G)+")))),
+                                             buildDFA(regexToNFA(toPostfix(preprocessRegex("[AG][AG]*")))));
+    cout << "(A|G)+ == [AG][AG]*: " << (rewrite.holds ? "EQUIVALENT" : "DIFFERS on '" + rewrite.counterexample + "'") << endl;
    
+    // Multi-rule lexer: keywords are listed before identifiers so they win ties
+    Lexer lexer({{"KEYWORD", "if|while"}, {"IDENT", "[a-z][a-z0-9]*"},
+                 {"NUMBER", "[0-9]+"}, {"SPACE", " +"}});
+    string source = "while x1 if 42";
+    vector<Token> lexTokens;
+    lexer.tokenize(source, lexTokens);
+    cout << "\nTokenizing '" << source << "' (" << lexer.automaton().stateCount() << " DFA states):" << endl;
+    for (const Token& t : lexTokens) {
+        if (lexer.tokenName(t.id) == "SPACE") continue;
+        cout << "  " << lexer.tokenName(t.id) << " '" << source.substr(t.offset, t.length) << "'" << endl;
+    }
+
     // Auto-cleanup happens via StateManager (No manual delete needed)
     StateManager::clear();
 
@@ -114,6 +212,15 @@ int main() {
 
     AdaptivePDA parser;
     parser.parse(tokens);
+
+    // Streamed variant: a lexer thread feeds the parser through a ring buffer
+    Lexer dnaLexer({{"A", "A"}, {"G", "G"}, {"C", "C"}, {"T", "T"}, {"U", "U"},
+                    {".", "\\."}, {"SPACE", "\\s+", true}});
+    string hairpin = string(100000, 'G') + "." + string(100000, 'C');
+    AdaptivePDA streamParser;
+    PipelineResult streamed = runPipeline(dnaLexer, hairpin, streamParser);
+    cout << "Streamed hairpin of " << streamed.tokenCount << " tokens: "
+         << (streamed.accepted ? "STABLE" : "REJECTED") << endl;
    
     cout << "\n[CONCLUSION] Heuristic threshold met (0.95 > 0.8). Mutation accepted." << endl;
 
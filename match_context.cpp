@@ -0,0 +1,46 @@
+#include "match_context.h"
+#include <memory>
+
+/**
+ * FILE: match_context.cpp
+ * DESCRIPTION: MatchContext preparation and the thread-local context pool
+ * PROCESS:
+ *
+ *   prepare():
+ *   - Bitsets are re-assigned to the automaton's size (vector::assign keeps
+ *     the capacity, so only a larger automaton reallocates); sparse sets
+ *     are only resized, their stale contents are never read
+ *   - Both active sets start on the bitset and switch after the first step
+ *     if the automaton is large and sparsely occupied
+ *   - Counting sets are never shrunk: destroying them would free their run
+ *     storage and the next larger automaton would allocate it again
+ *
+ *   Pool:
+ *   - Per-thread free list of contexts; a lease pops one (or creates the
+ *     first) and the destructor pushes it back, so a thread holds as many
+ *     contexts as its deepest nesting of simultaneous matches
+ */
+
+void MatchContext::prepare(size_t stateCount, size_t repeatCount) {
+    current.resize(stateCount);
+    next.resize(stateCount);
+    stack.clear();
+    if (sets.size() < repeatCount) sets.resize(repeatCount);
+    for (size_t k = 0; k < repeatCount; k++) sets[k].clear();
+    inserts.assign(repeatCount, 0);
+}
+
+static thread_local std::vector<std::unique_ptr<MatchContext>> freeContexts;
+
+PooledMatchContext::PooledMatchContext() {
+    if (freeContexts.empty()) {
+        context = new MatchContext();
+    } else {
+        context = freeContexts.back().release();
+        freeContexts.pop_back();
+    }
+}
+
+PooledMatchContext::~PooledMatchContext() {
+    freeContexts.emplace_back(context);
+}
@@ -0,0 +1,197 @@
+#ifndef MATCH_CONTEXT_H
+#define MATCH_CONTEXT_H
+
+#include "counting_set_automaton.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * FILE: match_context.h
+ * DESCRIPTION: Reusable per-match scratch memory for the simulating engines
+ * PROCESS:
+ *
+ *   1. StateBitset: dense set of active NFA states (one bit per state)
+ *      - insert() reports whether the state is new, so the same bitset is
+ *        both the active set and the visited mark of an ε-closure
+ *      - forEach() visits members in index order, skipping zero words
+ *      - clear() keeps the storage
+ *
+ *   2. SparseSet: Briggs-Torczon sparse set over the same universe
+ *      - members[0 .. count) lists the states in insertion order and
+ *        position[s] points into it; s is a member iff
+ *            position[s] < count && members[position[s]] == s
+ *        so stale entries never need clearing: insert(), contains() and
+ *        clear() are O(1), forEach() is O(members) instead of O(N / 64)
+ *
+ *   3. ActiveStates: picks one of the two by observed occupancy
+ *      - clear() looks at how many states the set held before emptying it:
+ *        fewer than words / 4 switches to the sparse set, more than words
+ *        switches back to the bitset (the gap keeps it from flip-flopping)
+ *      - Automata under SPARSE_MIN_STATES always stay on the bitset, whose
+ *        few words are cheaper than the sparse set's two arrays
+ *
+ *   4. MatchContext: all scratch one simulation needs
+ *      - current / next: active states before and after a byte
+ *      - stack:   closure worklist (no recursion)
+ *      - sets:    one CountingSet per counted repetition
+ *      - inserts: pending "insert 0" marks per counted repetition
+ *      - prepare(states, repeats) resets the scratch for an automaton,
+ *        growing it only when the automaton is larger than any seen before;
+ *        after that, repeated calls never touch the allocator
+ *
+ *   5. PooledMatchContext: RAII lease from a thread-local pool
+ *      - The constructor takes a context from the calling thread's free list
+ *        (or creates one), the destructor gives it back
+ *      - One context per nesting level per thread: no locking, and nested or
+ *        reentrant matches on one thread still get separate scratch
+ *      - Engines called without an explicit context lease one, so the
+ *        convenience overloads are allocation-free in the steady state too
+ */
+
+class StateBitset {
+    std::vector<uint64_t> words;
+    size_t count = 0;
+
+    static int lowestBit(uint64_t word) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+public:
+    void resize(size_t states) {
+        words.assign((states + 63) / 64, 0);
+        count = 0;
+    }
+    void clear() {
+        if (count == 0) return;
+        std::fill(words.begin(), words.end(), 0);
+        count = 0;
+    }
+    bool insert(int s) {
+        uint64_t bit = uint64_t(1) << (s & 63);
+        uint64_t& word = words[s >> 6];
+        if (word & bit) return false;
+        word |= bit;
+        count++;
+        return true;
+    }
+    bool contains(int s) const { return (words[s >> 6] >> (s & 63)) & 1; }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                visit(static_cast<int>(w * 64 + lowestBit(word)));
+            }
+        }
+    }
+};
+
+class SparseSet {
+    std::vector<int> members;         // Members in insertion order, first count entries valid
+    std::vector<uint32_t> position;   // position[s] = index of s in members, if s is a member
+    size_t count = 0;
+
+public:
+    void resize(size_t states) {
+        members.resize(states);       // Old contents are harmless: membership is re-checked
+        position.resize(states);
+        count = 0;
+    }
+    void clear() { count = 0; }
+    bool insert(int s) {
+        if (contains(s)) return false;
+        members[count] = s;
+        position[s] = static_cast<uint32_t>(count++);
+        return true;
+    }
+    bool contains(int s) const {
+        uint32_t i = position[s];
+        return i < count && members[i] == s;
+    }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (size_t i = 0; i < count; i++) visit(members[i]);
+    }
+};
+
+class ActiveStates {
+    StateBitset bits;
+    SparseSet list;
+    size_t words = 0;
+    bool sparse = false;
+
+public:
+    static constexpr size_t SPARSE_MIN_STATES = 1024;
+
+    void resize(size_t states) {
+        bits.resize(states);
+        list.resize(states);
+        words = (states + 63) / 64;
+        sparse = false;
+    }
+    void clear() {
+        size_t occupied = size();
+        if (sparse) {
+            list.clear();
+        } else {
+            bits.clear();
+        }
+        if (words * 64 < SPARSE_MIN_STATES) return;
+        if (sparse && occupied > words) sparse = false;
+        else if (!sparse && occupied * 4 < words) sparse = true;
+    }
+    bool insert(int s) { return sparse ? list.insert(s) : bits.insert(s); }
+    bool contains(int s) const { return sparse ? list.contains(s) : bits.contains(s); }
+    bool empty() const { return sparse ? list.empty() : bits.empty(); }
+    size_t size() const { return sparse ? list.size() : bits.size(); }
+    bool isSparse() const { return sparse; }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        if (sparse) {
+            list.forEach(visit);
+        } else {
+            bits.forEach(visit);
+        }
+    }
+};
+
+struct MatchContext {
+    ActiveStates current;
+    ActiveStates next;
+    std::vector<int> stack;
+    std::vector<CountingSet> sets;
+    std::vector<char> inserts;
+
+    void prepare(size_t stateCount, size_t repeatCount);
+};
+
+class PooledMatchContext {
+    MatchContext* context;
+
+public:
+    PooledMatchContext();
+    ~PooledMatchContext();
+    PooledMatchContext(const PooledMatchContext&) = delete;
+    PooledMatchContext& operator=(const PooledMatchContext&) = delete;
+
+    MatchContext& get() { return *context; }
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "match_planner.h"
+#include "regex_preprocessor.h"
+#include "thompsons_construction.h"
+#include "dfa_construction.h"
+#include "dfa_operations.h"
+#include "compiled_dfa.h"
+#include "match_context.h"
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * FILE: match_planner.cpp
+ * DESCRIPTION: Engine selection and dispatch for PatternMatcher
+ * PROCESS:
+ *
+ *   Constructor:
+ *   - Preprocess and convert to postfix once; isValidPostfix() rejects a
+ *     malformed regex before any engine sees it (regexToNFA() would exit)
+ *   - literalOf(): a postfix made only of plain bytes, escaped bytes and
+ *     concatenation dots is a literal
+ *   - chooseEngine(): each rule appends its reason to the plan as it is
+ *     taken, so the reasons read as the path through the decision list
+ *
+ *   matches():
+ *   - The prefilter, then one switch on the engine per call; the engines
+ *     themselves are the only per-byte work
+ *   - DERIVATIVE past derivativeStates: the matcher is dropped, the
+ *     NFA is built from the kept postfix and the same input is simulated;
+ *     every later call goes to COUNTING or NFA
+ *
+ *   matchAll():
+ *   - With dedup, BatchDedup lists the first occurrence of each distinct
+ *     input; only those are matched, then scattered back
+ */
+
+namespace {
+
+// The bytes of a postfix regex that is one literal, false if it has any operator
+bool literalOf(const std::string& postfix, std::string& literal) {
+    literal.clear();
+    for (size_t i = 0; i < postfix.length();) {
+        size_t end = regexTokenEnd(postfix, i);
+        char c = postfix[i];
+        if (c == '\\' && end - i == 2) literal += postfix[i + 1];
+        else if (end - i != 1 || c == '|' || c == '*' || c == '+' || c == '[' || c == '{') return false;
+        else if (c != '.') literal += c;
+        i = end;
+    }
+    return true;
+}
+
+}  // namespace
+
+const char* engineName(MatchEngine engine) {
+    switch (engine) {
+        case MatchEngine::LITERAL: return "literal";
+        case MatchEngine::SHENG: return "sheng";
+        case MatchEngine::TABLE: return "table-dfa";
+        case MatchEngine::JIT: return "jit";
+        case MatchEngine::DERIVATIVE: return "derivative";
+        case MatchEngine::COUNTING: return "counting-set";
+        case MatchEngine::NFA: return "nfa";
+    }
+    return "?";
+}
+
+std::string MatchPlan::describe() const {
+    std::string text = engineName(engine);
+    for (size_t i = 0; i < reasons.size(); i++) text += (i == 0 ? ": " : "; ") + reasons[i];
+    return text;
+}
+
+PatternMatcher::PatternMatcher(const std::string& regex, MatchWorkload workload, bool utf8, int derivativeStates)
+    : postfix(toPostfix(preprocessRegex(regex))), derivativeStates(derivativeStates) {
+    if (!isValidPostfix(postfix)) throw std::runtime_error("malformed regex '" + regex + "'");
+    std::vector<std::string>& why = chosen.reasons;
+
+    if (literalOf(postfix, literal)) {
+        chosen.engine = MatchEngine::LITERAL;
+        why.push_back("no operators, " + std::to_string(literal.size()) + "-byte literal");
+        return;
+    }
+    analyzed = analyzePattern(postfix, utf8);
+    chooseEngine(workload, utf8);
+
+    // A DFA rejects at table speed; only the simulated engines are slow enough for memchr scans to pay
+    filter = analyzed;
+    if (dfa) filter.scanCount = 0;
+    prefilter = filter.selective();
+    if (prefilter) why.push_back("prefilter " + analyzed.describe() + (filter.scanCount ? ", scanned" : ""));
+}
+
+void PatternMatcher::chooseEngine(MatchWorkload workload, bool utf8) {
+    std::vector<std::string>& why = chosen.reasons;
+    size_t tokens = 0;
+    for (size_t i = 0; i < postfix.length(); i = regexTokenEnd(postfix, i)) tokens++;
+
+    if (workload == MatchWorkload::ONE_SHOT && !utf8 && tokens <= DERIVATIVE_TOKEN_LIMIT) {
+        chosen.engine = MatchEngine::DERIVATIVE;
+        why.push_back("one-shot: lazy derivative states, no NFA or DFA construction");
+        derivative.reset(new DerivativeMatcher(postfix, derivativeStates));
+        return;
+    }
+
+    int before = StateManager::getStateCount();
+    NFAFragment nfa = regexToNFA(postfix, utf8);
+    why.push_back("NFA " + std::to_string(StateManager::getStateCount() - before) + " states");
+
+    if (workload == MatchWorkload::BATCH) {
+        try {
+            DFA built = buildDFA(nfa, DFA_STATE_LIMIT);
+            DFA minimal = minimizeDFA(built);
+            why.push_back("DFA " + std::to_string(built.stateCount()) + " -> " +
+                          std::to_string(minimal.stateCount()) + " states minimized");
+            CompiledDFA compiled = compileDFA(minimal);
+            if (!compiled.sheng.empty()) {
+                chosen.engine = MatchEngine::SHENG;
+                why.push_back("fits the 16-state shuffle engine");
+            } else if (DFAJit::available()) {
+                chosen.engine = MatchEngine::JIT;
+                why.push_back("table for " + std::to_string(HotDFA::JIT_THRESHOLD) + " calls, then native code");
+            } else {
+                chosen.engine = MatchEngine::TABLE;
+                why.push_back("no JIT in this build");
+            }
+            dfa.reset(new HotDFA(std::move(compiled)));
+            return;
+        } catch (const std::runtime_error&) {
+            why.push_back("DFA over " + std::to_string(DFA_STATE_LIMIT) + " states");
+        }
+    } else if (utf8) {
+        why.push_back("one-shot --utf8: derivatives are byte-only, simulate without determinizing");
+    } else {
+        why.push_back("one-shot, " + std::to_string(tokens) + " regex tokens: derivative terms grow too fast, " +
+                      "simulate without determinizing");
+    }
+    simulate(nfa);
+}
+
+void PatternMatcher::simulate(const NFAFragment& nfa) {
+    counting = buildCountingNFA(nfa);
+    if (counting.supported) {
+        chosen.engine = MatchEngine::COUNTING;
+        chosen.reasons.push_back(std::to_string(counting.repeats.size()) + " counted repeats as counting sets");
+    } else {
+        chosen.engine = MatchEngine::NFA;
+        chosen.reasons.push_back("repeats too general for counting sets");
+    }
+}
+
+bool PatternMatcher::matches(const char* data, size_t size) {
+    if (prefilter && !filter.mayMatch(data, size)) return false;
+    switch (chosen.engine) {
+        case MatchEngine::LITERAL:
+            return size == literal.size() && std::memcmp(data, literal.data(), size) == 0;
+        case MatchEngine::SHENG:
+        case MatchEngine::TABLE:
+        case MatchEngine::JIT:
+            return dfa->matches(data, size);
+        case MatchEngine::DERIVATIVE:
+            try {
+                return derivative->matches(data, size);
+            } catch (const std::runtime_error&) {
+                // The inputs visited too many states: switch this matcher to simulation for good
+                derivative.reset();
+                chosen.reasons.push_back("derivative states over " + std::to_string(derivativeStates));
+                simulate(regexToNFA(postfix));
+                return simulateCountingNFA(counting, data, size);
+            }
+        case MatchEngine::COUNTING:
+        case MatchEngine::NFA:
+            return simulateCountingNFA(counting, data, size);
+    }
+    return false;
+}
+
+void PatternMatcher::matchAll(const std::vector<std::string>& inputs, std::vector<char>& results, bool dedup) {
+    PooledMatchContext context;
+    auto matchOne = [&](const std::string& input) -> char {
+        if (chosen.engine != MatchEngine::COUNTING) return matches(input);
+        return (!prefilter || filter.mayMatch(input.data(), input.size())) &&
+               simulateCountingNFA(counting, input, context.get());
+    };
+
+    if (!dedup) {
+        results.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) results[i] = matchOne(inputs[i]);
+        return;
+    }
+    unique.build(inputs);
+    distinctResults.resize(unique.distinctCount());
+    for (size_t k = 0; k < unique.distinctCount(); k++) distinctResults[k] = matchOne(inputs[unique.distinct()[k]]);
+    unique.scatter(distinctResults, results);
+}
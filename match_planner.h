@@ -0,0 +1,125 @@
+#ifndef MATCH_PLANNER_H
+#define MATCH_PLANNER_H
+
+#include "counting_set_automaton.h"
+#include "dfa_jit.h"
+#include "derivative_matcher.h"
+#include "pattern_analysis.h"
+#include "batch_dedup.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * FILE: match_planner.h
+ * DESCRIPTION: Picks the matching engine for a pattern and a workload
+ * PROCESS:
+ *
+ *   Every engine wins somewhere and loses somewhere else. PatternMatcher
+ *   compiles a regex once, looks at what it got and at how it will be
+ *   called, and routes every match to one engine:
+ *
+ *   1. Workload (the call type)
+ *      - ONE_SHOT: a handful of inputs; compile time dominates
+ *      - BATCH: many inputs (lines of a file, a corpus); match time dominates
+ *
+ *   2. Decision, first rule that applies
+ *      - LITERAL: no operator at all ("GATTACA"): a length check and memcmp
+ *      - DERIVATIVE: ONE_SHOT byte patterns of at most DERIVATIVE_TOKEN_LIMIT
+ *        postfix tokens; the lazy derivative DFA builds only the states the
+ *        inputs visit, with no NFA or subset construction
+ *      - Otherwise the Thompson NFA is built, then:
+ *        - ONE_SHOT with --utf8 (the derivative matcher is byte-only), or
+ *          a longer pattern (a? x 1000: derivatives of long chains of
+ *          optional terms have quadratically many subterms, minutes against
+ *          half a second of simulation): COUNTING or NFA simulation,
+ *          nothing is determinized
+ *        - BATCH: subset construction up to DFA_STATE_LIMIT states, then
+ *          minimization and compileDFA():
+ *            SHENG  when it fits the shuffle engine
+ *            JIT    when native code is available (HotDFA: the table for
+ *                   the first JIT_THRESHOLD calls, then native code)
+ *            TABLE  otherwise
+ *        - A DFA over the limit (a{1000}.*b{1000}, large UTF-8 classes):
+ *          COUNTING when every counter is a single-class repeat, else NFA
+ *
+ *   3. Prefilter (pattern_analysis.h): the pattern's length bounds and
+ *      first bytes reject inputs before the engine sees them, for every
+ *      engine but LITERAL, when they can reject anything at all. Required
+ *      bytes (memchr scans) only guard DERIVATIVE, COUNTING and NFA: a DFA
+ *      rejects a near miss about as fast as a scan would
+ *
+ *   4. plan(): the chosen engine and one reason per decision taken (sizes
+ *      included, then the prefilter), e.g. for `atfl match --explain`
+ *
+ *   5. matches(input) / matchAll(inputs, results)
+ *      - matchAll() runs a batch on the same engine; the counting-set
+ *        engine reuses one MatchContext for the whole batch
+ *      - matchAll(..., dedup = true) matches each distinct input once
+ *        (batch_dedup.h) and copies its result to every duplicate; worth
+ *        it when inputs repeat, a hash per input otherwise
+ *      - matches() is not const: the derivative engine fills its cache as
+ *        it goes, so a PatternMatcher is not shared between threads
+ *      - When the inputs drive DERIVATIVE past derivativeStates states
+ *        ((a|b)*a(a|b){20} on a long random text), matches() switches the
+ *        matcher to COUNTING or NFA, adds the reason to the plan and
+ *        answers from there; the limit defaults to DERIVATIVE_STATE_LIMIT,
+ *        the differential fuzzer lowers it to reach the fallback on short
+ *        subjects
+ *      - COUNTING and NFA keep pointers into the NFA: StateManager::clear()
+ *        invalidates them (like any NFAFragment)
+ *
+ *   The constructor throws std::runtime_error on a malformed regex;
+ *   matches() and matchAll() do not throw.
+ */
+
+enum class MatchEngine { LITERAL, SHENG, TABLE, JIT, DERIVATIVE, COUNTING, NFA };
+enum class MatchWorkload { ONE_SHOT, BATCH };
+
+const char* engineName(MatchEngine engine);
+
+struct MatchPlan {
+    MatchEngine engine = MatchEngine::NFA;
+    std::vector<std::string> reasons;
+
+    std::string describe() const;  // "engine: reason; reason; ..."
+};
+
+class PatternMatcher {
+public:
+    static constexpr size_t DFA_STATE_LIMIT = 1 << 14;       // Past this, determinizing costs more than it saves
+    static constexpr size_t DERIVATIVE_TOKEN_LIMIT = 256;    // Longer one-shot patterns are simulated
+    static constexpr int DERIVATIVE_STATE_LIMIT = 1 << 12;   // 4 MB of cached rows, then simulated
+
+    explicit PatternMatcher(const std::string& regex, MatchWorkload workload = MatchWorkload::BATCH,
+                            bool utf8 = false, int derivativeStates = DERIVATIVE_STATE_LIMIT);
+
+    bool matches(const char* data, size_t size);
+    bool matches(const std::string& input) { return matches(input.data(), input.size()); }
+
+    // results[i] = whether inputs[i] matches (resized to inputs.size())
+    void matchAll(const std::vector<std::string>& inputs, std::vector<char>& results, bool dedup = false);
+
+    const MatchPlan& plan() const { return chosen; }
+    const PatternAnalysis& analysis() const { return analyzed; }
+
+private:
+    std::string postfix;
+    int derivativeStates;
+    MatchPlan chosen;
+    PatternAnalysis analyzed;
+    PatternAnalysis filter;                         // analyzed, without scans on DFA engines
+    bool prefilter = false;
+    std::string literal;
+    std::unique_ptr<HotDFA> dfa;                    // SHENG, TABLE, JIT
+    std::unique_ptr<DerivativeMatcher> derivative;
+    CountingNFA counting;                           // COUNTING, NFA (falls back to simulateNFA)
+    BatchDedup unique;                              // matchAll(..., dedup) scratch
+    std::vector<char> distinctResults;
+
+    void chooseEngine(MatchWorkload workload, bool utf8);
+    void simulate(const NFAFragment& nfa);  // COUNTING, or NFA when counting sets do not apply
+};
+
+#endif
@@ -1,79 +1,223 @@
 #include "nfa_simulator.h"
 #include <sstream>
+#include <algorithm>
 
 /**
  * FILE: nfa_simulator.cpp
  * DESCRIPTION: Implementation of NFA simulation with subset construction
  * PROCESS:
  *
- *   getEpsilonClosure():
- *   - DFS traversal following epsilon transitions
- *   - Marks visited states by ID to prevent revisiting
- *   - Collects all epsilon-reachable states
- *   - Time: O(|states| + |transitions|)
+ *   EpsilonClosure:
+ *   - begin(): generation++; when the counter wraps to 0 the stamps are
+ *     zeroed once and counting restarts at 1
+ *   - add(): pop a state, skip it if stamped, stamp it, emit it, push its
+ *     ε-targets in reverse so the preferred one is popped first
+ *   - IDs are global (NFAState::globalID), so the stamps cover every ID
+ *     handed out; states created after reserve() grow them on first visit
+ *   - Time: O(|states| + |transitions|) per closure, O(1) to reset
+ *
+ *   getConfigClosure():
+ *   - Same DFS over (state, counts) configurations on a thread-local
+ *     explicit stack; the closure set itself is the visited set
+ *   - Counter check state: c = counts[k] + 1
+ *     * c < max (or unbounded): ε to the loop start with counts[k] = c
+ *       (unbounded counters saturate at min, keeping the state space finite)
+ *     * c >= min: ε to the exit with counts[k] = 0
  *
  *   simulateNFA():
- *   - Start: Compute epsilon closure of NFA start state
+ *   - Start: ε-closure of the NFA start state
  *   - For each character in input:
  *     1. For each current state, find direct transitions on that character
- *     2. Apply epsilon closure to each reachable state
- *     3. Update current state set
- *     4. If no states remain, input rejected
+ *     2. Add the ε-closure of each target to the next state list; one
+ *        walker generation per step, so a state is listed at most once
+ *     3. Swap the lists; if none remain, input rejected
  *   - Accept: If any current state equals an NFA final state
- *   - Time: O(|input| * |states|^2) worst case
+ *   - The walker and both lists are thread-local and keep their capacity:
+ *     after the first call on an automaton a match does not allocate
+ *   - A counter check state among the current states means the NFA has
+ *     bounded repetitions: the input is rerun from the start by
+ *     simulateConfigs(), the same loop over (state, counts) configuration
+ *     sets built by getConfigClosure()
+ *   - Time: O(|input| * |transitions|) without counters, O(|input| *
+ *     |configurations|^2) worst case with them
  */
 
-void getEpsilonClosure(NFAState* s, std::set<int>& visited, std::set<NFAState*>& closure) {
-    if (visited.count(s->id)) return;
-    visited.insert(s->id);
-    closure.insert(s);
-    if (s->transitions.count('E')) {
-        for (auto next : s->transitions['E']) {
-            getEpsilonClosure(next, visited, closure);
+static int counterValue(const std::vector<int>& counts, int k) {
+    return k < static_cast<int>(counts.size()) ? counts[k] : 0;
+}
+
+// Copy of counts with counter k set to value, trailing zeros trimmed
+static std::vector<int> withCounter(std::vector<int> counts, int k, int value) {
+    if (k >= static_cast<int>(counts.size())) {
+        if (value == 0) return counts;
+        counts.resize(k + 1, 0);
+    }
+    counts[k] = value;
+    while (!counts.empty() && counts.back() == 0) counts.pop_back();
+    return counts;
+}
+
+static void writeConfig(std::ostringstream& trace, const NFAConfig& config) {
+    trace << "q" << config.state->id;
+    if (!config.counts.empty()) {
+        trace << "[";
+        for (size_t k = 0; k < config.counts.size(); k++) {
+            if (k > 0) trace << ",";
+            trace << config.counts[k];
         }
+        trace << "]";
+    }
+}
+
+static bool isFinal(const NFAFragment& nfa, NFAState* s) {
+    for (auto f : nfa.finals) {
+        if (s == f) return true;
+    }
+    return false;
+}
+
+void EpsilonClosure::reserve() {
+    if (stamp.size() < static_cast<size_t>(NFAState::globalID)) stamp.resize(NFAState::globalID, 0);
+    stack.reserve(2 * static_cast<size_t>(StateManager::getStateCount()) + 1);  // Thompson states have <= 2 ε-edges
+}
+
+void EpsilonClosure::begin() {
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+}
+
+void EpsilonClosure::add(NFAState* start, std::vector<NFAState*>& out) {
+    stack.push_back(start);
+    while (!stack.empty()) {
+        NFAState* s = stack.back();
+        stack.pop_back();
+        if (static_cast<size_t>(s->id) >= stamp.size()) stamp.resize(NFAState::globalID, 0);
+        if (stamp[s->id] == generation) continue;
+        stamp[s->id] = generation;
+        out.push_back(s);
+        for (auto it = s->epsilon.rbegin(); it != s->epsilon.rend(); ++it) stack.push_back(*it);
     }
 }
 
-bool simulateNFA(NFAFragment nfa, std::string input) {
-    std::set<NFAState*> currentStates;
-    std::set<int> visited;
-    getEpsilonClosure(nfa.start, visited, currentStates);
-
-    for (char c : input) {
-        std::set<NFAState*> nextStates;
-        for (auto s : currentStates) {
-            if (s->transitions.count(c)) {
-                for (auto next : s->transitions[c]) {
-                    std::set<int> v;
-                    getEpsilonClosure(next, v, nextStates);
-                }
+void getEpsilonClosure(NFAState* s, std::set<NFAState*>& closure) {
+    static thread_local EpsilonClosure walker;
+    static thread_local std::vector<NFAState*> states;
+    states.clear();
+    walker.begin();
+    walker.add(s, states);
+    closure.insert(states.begin(), states.end());
+}
+
+void getConfigClosure(const NFAConfig& config, std::set<NFAConfig>& closure) {
+    static thread_local std::vector<NFAConfig> stack;
+    size_t bottom = stack.size();
+    stack.push_back(config);
+
+    while (stack.size() > bottom) {
+        auto inserted = closure.insert(std::move(stack.back()));
+        stack.pop_back();
+        if (!inserted.second) continue;
+        const NFAConfig& current = *inserted.first;
+        NFAState* s = current.state;
+
+        // Successors are pushed in reverse so the preferred one is expanded first
+        if (s->counter >= 0) {
+            const NFACounter& counter = StateManager::counterStore[s->counter];
+            int c = counterValue(current.counts, s->counter) + 1;
+            bool canLoop = (counter.max < 0 || c < counter.max);
+            bool canExit = (c >= counter.min);
+            int kept = (counter.max < 0) ? std::min(c, counter.min) : c;
+
+            if (canLoop && counter.lazy) {
+                stack.push_back({counter.loop, withCounter(current.counts, s->counter, kept)});
+            }
+            if (canExit) {
+                stack.push_back({counter.exit, withCounter(current.counts, s->counter, 0)});
+            }
+            if (canLoop && !counter.lazy) {
+                stack.push_back({counter.loop, withCounter(current.counts, s->counter, kept)});
             }
+            continue;
+        }
+
+        for (auto it = s->epsilon.rbegin(); it != s->epsilon.rend(); ++it) {
+            stack.push_back({*it, current.counts});
         }
-        currentStates = nextStates;
-        if (currentStates.empty()) return false;
     }
+}
 
-    for(auto s : currentStates) {
-        for(auto f : nfa.finals) {
-            if(s == f) return true;
+// Reference simulation over (state, counts) configurations, for NFAs with counters
+static bool simulateConfigs(const NFAFragment& nfa, const char* data, size_t size) {
+    std::set<NFAConfig> current;
+    getConfigClosure({nfa.start, {}}, current);
+
+    for (size_t i = 0; i < size; i++) {
+        std::set<NFAConfig> next;
+        for (const auto& config : current) {
+            auto it = config.state->transitions.find(data[i]);
+            if (it == config.state->transitions.end()) continue;
+            for (auto target : it->second) {
+                getConfigClosure({target, config.counts}, next);
+            }
+        }
+        current.swap(next);
+        if (current.empty()) return false;
+    }
+
+    for (const auto& config : current) {
+        if (isFinal(nfa, config.state)) return true;
+    }
+    return false;
+}
+
+bool simulateNFA(const NFAFragment& nfa, const char* data, size_t size) {
+    static thread_local EpsilonClosure walker;
+    static thread_local std::vector<NFAState*> current, next;
+    walker.reserve();
+    current.clear();
+    walker.begin();
+    walker.add(nfa.start, current);
+
+    for (size_t i = 0; i < size; i++) {
+        next.clear();
+        walker.begin();
+        for (NFAState* s : current) {
+            if (s->counter >= 0) return simulateConfigs(nfa, data, size);
+            auto it = s->transitions.find(data[i]);
+            if (it == s->transitions.end()) continue;
+            for (auto target : it->second) walker.add(target, next);
         }
+        current.swap(next);
+        if (current.empty()) return false;
+    }
+
+    for (NFAState* s : current) {
+        if (s->counter >= 0) return simulateConfigs(nfa, data, size);
+    }
+    for (NFAState* s : current) {
+        if (isFinal(nfa, s)) return true;
     }
     return false;
 }
 
+bool simulateNFA(const NFAFragment& nfa, const std::string& input) {
+    return simulateNFA(nfa, input.data(), input.size());
+}
+
 std::string simulateNFAWithTrace(NFAFragment nfa, std::string input) {
     std::ostringstream trace;
-    std::set<NFAState*> currentStates;
-    std::set<int> visited;
-    
-    getEpsilonClosure(nfa.start, visited, currentStates);
-    
+    std::set<NFAConfig> current;
+
+    getConfigClosure({nfa.start, {}}, current);
+
     trace << "      Step 0: Initial ε-closure from state q" << nfa.start->id << "\n";
     trace << "              Current states: {";
     bool first = true;
-    for (auto s : currentStates) {
+    for (const auto& config : current) {
         if (!first) trace << ", ";
-        trace << "q" << s->id;
+        writeConfig(trace, config);
         first = false;
     }
     trace << "}\n\n";
@@ -81,38 +225,40 @@ std::string simulateNFAWithTrace(NFAFragment nfa, std::string input) {
     int step = 1;
     for (size_t i = 0; i < input.length(); i++) {
         char c = input[i];
-        std::set<NFAState*> nextStates;
-        
+        std::set<NFAConfig> next;
+
         trace << "      Step " << step++ << ": Read '" << c << "' (position " << i << ")\n";
-        
-        for (auto s : currentStates) {
-            if (s->transitions.count(c)) {
-                trace << "              State q" << s->id << " --[" << c << "]--> ";
-                bool firstTrans = true;
-                for (auto next : s->transitions[c]) {
-                    if (!firstTrans) trace << ", ";
-                    trace << "q" << next->id;
-                    firstTrans = false;
-                    
-                    std::set<int> v;
-                    getEpsilonClosure(next, v, nextStates);
-                }
-                trace << "\n";
+
+        for (const auto& config : current) {
+            auto it = config.state->transitions.find(c);
+            if (it == config.state->transitions.end()) continue;
+
+            trace << "              State ";
+            writeConfig(trace, config);
+            trace << " --[" << c << "]--> ";
+            bool firstTrans = true;
+            for (auto target : it->second) {
+                if (!firstTrans) trace << ", ";
+                trace << "q" << target->id;
+                firstTrans = false;
+
+                getConfigClosure({target, config.counts}, next);
             }
+            trace << "\n";
         }
-        
-        currentStates = nextStates;
-        
+
+        current.swap(next);
+
         trace << "              After ε-closure: {";
         first = true;
-        for (auto s : currentStates) {
+        for (const auto& config : current) {
             if (!first) trace << ", ";
-            trace << "q" << s->id;
+            writeConfig(trace, config);
             first = false;
         }
         trace << "}\n";
-        
-        if (currentStates.empty()) {
+
+        if (current.empty()) {
             trace << "              DEAD STATE - No valid transitions\n";
             return trace.str();
         }
@@ -121,20 +267,17 @@ std::string simulateNFAWithTrace(NFAFragment nfa, std::string input) {
 
     trace << "      Final Check: ";
     bool accepted = false;
-    for(auto s : currentStates) {
-        for(auto f : nfa.finals) {
-            if(s == f) {
-                accepted = true;
-                trace << "State q" << s->id << " is a final state\n";
-                break;
-            }
+    for (const auto& config : current) {
+        if (isFinal(nfa, config.state)) {
+            accepted = true;
+            trace << "State q" << config.state->id << " is a final state\n";
+            break;
         }
-        if (accepted) break;
     }
-    
+
     if (!accepted) {
         trace << "No current state is a final state\n";
     }
-    
+
     return trace.str();
 }
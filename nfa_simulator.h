@@ -2,31 +2,81 @@
 #define NFA_SIMULATOR_H
 
 #include "nfa_state.h"
+#include <cstdint>
+#include <cstddef>
 #include <string>
 #include <set>
+#include <vector>
 
 /**
  * FILE: nfa_simulator.h
  * DESCRIPTION: NFA simulation and epsilon closure computation (Subset Construction)
  * PROCESS:
- *   
- *   1. getEpsilonClosure(s, visited, closure)
- *      - Recursive DFS to find all states reachable via epsilon (E) transitions
- *      - Uses visited set to prevent infinite loops
- *      - Adds all reachable states to closure set
- *      - Core of subset construction algorithm
  *
- *   2. simulateNFA(nfa, input)
+ *   1. EpsilonClosure: reusable plain-state ε-closure walker
+ *      - Iterative DFS on one explicit stack, so the depth of ε-chains
+ *        (long runs of a?a?a?...) is not limited by the call stack
+ *      - Visited marks are generation stamps indexed by state ID: state s
+ *        is in the current closure iff stamp[s->id] == generation, so
+ *        begin() forgets every mark in O(1) without touching the array
+ *      - reserve() sizes the stamps and the stack for every state created
+ *        so far; after that a closure over them never allocates (the
+ *        caller's output vector aside)
+ *      - Plain state closure: counter check states are not expanded
+ *
+ *   getEpsilonClosure(s, closure): one closure added to a std::set, on a
+ *   thread-local walker
+ *
+ *   2. NFAConfig: (state, counter values) pair
+ *      - Counters of bounded repetitions {n,m} make the NFA state alone
+ *        insufficient; a configuration also records the counter values
+ *      - counts[k] is the value of counter k; absent/trailing entries are 0,
+ *        so counter-free NFAs always have an empty counts vector
+ *
+ *   3. getConfigClosure(config, closure)
+ *      - ε-closure over configurations, iterative like EpsilonClosure; the
+ *        closure set itself is the visited set
+ *      - At a counter check state: count+1, loop back while below max,
+ *        exit (resetting the count) once at least min
+ *
+ *   4. simulateNFA(nfa, input) or (nfa, data, size)
  *      - Simulates NFA execution on input string
- *      - Maintains set of current states (subset of original NFA states)
- *      - For each input character:
- *        * Compute next states from all current states
- *        * Apply epsilon closure to each reachable state
+ *      - Counter-free NFAs: a list of current states, stepped with an
+ *        EpsilonClosure walker; the walker and lists are reused across
+ *        calls, so steady-state matching does not allocate
+ *      - NFAs with counters: a set of current configurations, stepped with
+ *        getConfigClosure()
  *      - Returns true if any final state is reached after consuming input
  */
 
-void getEpsilonClosure(NFAState* s, std::set<int>& visited, std::set<NFAState*>& closure);
-bool simulateNFA(NFAFragment nfa, std::string input);
+struct NFAConfig {
+    NFAState* state;
+    std::vector<int> counts;
+
+    bool operator<(const NFAConfig& other) const {
+        if (state->id != other.state->id) return state->id < other.state->id;
+        if (state != other.state) return state < other.state;
+        return counts < other.counts;
+    }
+};
+
+class EpsilonClosure {
+    std::vector<uint32_t> stamp;    // stamp[id] == generation: visited in the current closure
+    uint32_t generation = 0;
+    std::vector<NFAState*> stack;
+
+public:
+    void reserve();
+    void begin();
+    // Appends start and every state ε-reachable from it that the current
+    // closure has not visited yet, in DFS preorder (preferred edges first)
+    void add(NFAState* start, std::vector<NFAState*>& out);
+};
+
+void getEpsilonClosure(NFAState* s, std::set<NFAState*>& closure);
+void getConfigClosure(const NFAConfig& config, std::set<NFAConfig>& closure);
+bool simulateNFA(const NFAFragment& nfa, const std::string& input);
+bool simulateNFA(const NFAFragment& nfa, const char* data, size_t size);
 std::string simulateNFAWithTrace(NFAFragment nfa, std::string input);
 
 #endif
@@ -7,11 +7,13 @@
  *   1. Initialize global state storage vector
  *   2. Initialize global state ID counter to 0
  *   3. StateManager::create() - allocates new NFAState and stores in unique_ptr
- *   4. StateManager::clear() - deallocates all stored states automatically
+ *   4. StateManager::createCounter() - registers a bounded-repetition counter
+ *   5. StateManager::clear() - deallocates all stored states and counters
  */
 
 int NFAState::globalID = 0;
 std::vector<std::unique_ptr<NFAState>> StateManager::stateStore;
+std::vector<NFACounter> StateManager::counterStore;
 
 NFAState* StateManager::create() {
     auto state = std::make_unique<NFAState>();
@@ -20,8 +22,14 @@ NFAState* StateManager::create() {
     return ptr;
 }
 
+int StateManager::createCounter(const NFACounter& counter) {
+    counterStore.push_back(counter);
+    return static_cast<int>(counterStore.size()) - 1;
+}
+
 void StateManager::clear() {
     stateStore.clear();
+    counterStore.clear();
 }
 
 void StateManager::resetID() {
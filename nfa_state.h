@@ -11,21 +11,44 @@
  * PROCESS: 
  *   1. NFAState: Represents individual states in the NFA with:
  *      - Unique integer ID for state tracking
- *      - Transition map: maps input characters to next states (supports epsilon transitions)
+ *      - Transition map: maps input bytes to next states
+ *      - Epsilon list: ε-transitions kept apart from the byte map, in priority
+ *        order (first = preferred), so every byte value is a valid literal
+ *      - Counter index: >= 0 marks a counter check state of a bounded
+ *        repetition {n,m} (see NFACounter); -1 for ordinary states
  *      - Global ID counter to ensure unique identifiers
- * 
- *   2. StateManager: Global memory manager for NFA states
+ *
+ *   2. NFACounter: Counting construct for bounded repetition X{min,max}
+ *      - Reaching the check state increments the counter (one more X matched)
+ *      - count < max  -> ε to loop (match X again)
+ *      - count >= min -> ε to exit, counter reset to 0
+ *      - max = -1 means unbounded ({n,}); lazy prefers exit over loop
+ *      - X{1000} costs a handful of states instead of 1000 copies of X
+ *
+ *   3. StateManager: Global memory manager for NFA states
  *      - Creates and stores NFAState objects in unique_ptr containers
  *      - Ensures automatic cleanup and prevents memory leaks
  *      - Provides interface to create new states and clear all states
+ *      - Owns the counter table referenced by counter check states
  */
 
 struct NFAState;
 
+struct NFACounter {
+    int min;
+    int max;           // -1 = unbounded
+    bool lazy;
+    NFAState* entry;   // State that starts the repetition
+    NFAState* loop;    // Start of the repeated fragment
+    NFAState* exit;    // State reached once the repetition is done
+};
+
 // Global Owner for Automatic Memory Management
 struct StateManager {
     static std::vector<std::unique_ptr<NFAState>> stateStore;
+    static std::vector<NFACounter> counterStore;
     static NFAState* create();
+    static int createCounter(const NFACounter& counter);
     static void clear();
     static int getStateCount();
     static void resetID();
@@ -33,7 +56,9 @@ struct StateManager {
 
 struct NFAState {
     int id;
-    std::map<char, std::vector<NFAState*>> transitions;  // Character -> Next States mapping
+    std::map<char, std::vector<NFAState*>> transitions;  // Byte -> Next States mapping
+    std::vector<NFAState*> epsilon;                      // ε-transitions, preferred first
+    int counter = -1;                                    // Counter check state if >= 0
     static int globalID;
 
     NFAState() { id = globalID++; }
@@ -0,0 +1,166 @@
+#include "pattern_analysis.h"
+#include "regex_preprocessor.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * FILE: pattern_analysis.cpp
+ * DESCRIPTION: Postfix walk computing PatternAnalysis
+ * PROCESS:
+ *
+ *   analyzePattern():
+ *   - Same token loop as regexToNFA(), with one Facts entry per operand on
+ *     the stack instead of an NFA fragment
+ *   - Lengths use saturating arithmetic: anything that overflows is
+ *     UNBOUNDED, which is still conservative for both bounds
+ *   - Scan bytes: the required bytes sorted by rarityRank(), first
+ *     MAX_SCANS kept
+ */
+
+namespace {
+
+const size_t UNBOUNDED = PatternAnalysis::UNBOUNDED;
+
+struct Facts {
+    size_t min, max;
+    std::bitset<256> first, required;
+};
+
+size_t add(size_t a, size_t b) {
+    return (a > UNBOUNDED - b) ? UNBOUNDED : a + b;
+}
+
+size_t multiply(size_t a, size_t n) {
+    if (a == 0 || n == 0) return 0;
+    return (a > UNBOUNDED / n) ? UNBOUNDED : a * n;
+}
+
+Facts byteClass(const std::bitset<256>& bytes) {
+    if (bytes.none()) return {UNBOUNDED, 0, {}, {}};
+    return {1, 1, bytes, bytes.count() == 1 ? bytes : std::bitset<256>()};
+}
+
+Facts codePointClass(const std::vector<CodePointRange>& ranges) {
+    static const int LENGTH_LIMITS[] = {0x7F, 0x7FF, 0xFFFF, MAX_CODE_POINT};
+    Facts facts = {UNBOUNDED, 0, {}, {}};
+    for (const auto& r : ranges) {
+        int segmentLo = 0;
+        for (int limit : LENGTH_LIMITS) {
+            int lo = std::max(r.lo, segmentLo), hi = std::min(r.hi, limit);
+            segmentLo = limit + 1;
+            if (lo > hi) continue;
+            int low[4], high[4], length;
+            encodeUtf8(lo, low, length);
+            encodeUtf8(hi, high, length);
+            facts.min = std::min<size_t>(facts.min, length);
+            facts.max = std::max<size_t>(facts.max, length);
+            for (int b = low[0]; b <= high[0]; b++) facts.first.set(b);
+        }
+    }
+    if (ranges.size() == 1 && ranges[0].lo == ranges[0].hi) {
+        int bytes[4], length;
+        encodeUtf8(ranges[0].lo, bytes, length);
+        for (int k = 0; k < length; k++) facts.required.set(bytes[k]);
+    }
+    return facts;
+}
+
+Facts concat(const Facts& r, const Facts& s) {
+    Facts facts = {add(r.min, s.min), add(r.max, s.max), r.first, r.required | s.required};
+    if (r.min == 0) facts.first |= s.first;
+    return facts;
+}
+
+Facts alternate(const Facts& r, const Facts& s) {
+    return {std::min(r.min, s.min), std::max(r.max, s.max), r.first | s.first, r.required & s.required};
+}
+
+// r{min,max}, max = -1 if unbounded; r* is r{0,} and r+ is r{1,}
+Facts repeat(const Facts& r, int min, int max) {
+    if (max == 0) return {0, 0, {}, {}};
+    return {multiply(r.min, min), max < 0 ? (r.max == 0 ? 0 : UNBOUNDED) : multiply(r.max, max),
+            r.first, min > 0 ? r.required : std::bitset<256>()};
+}
+
+// Lower = checked first: bytes that are rare in typical text
+int rarityRank(int b) {
+    if (std::islower(b) || b == ' ') return 3;
+    if (std::isdigit(b)) return 2;
+    if (std::isupper(b)) return 1;
+    return 0;
+}
+
+std::string byteName(int b) {
+    if (std::isprint(b)) return std::string("'") + static_cast<char>(b) + "'";
+    const char* hex = "0123456789abcdef";
+    return std::string("\\x") + hex[b >> 4] + hex[b & 15];
+}
+
+}  // namespace
+
+PatternAnalysis analyzePattern(const std::string& postfix, bool utf8) {
+    std::vector<Facts> stack;
+    for (size_t i = 0; i < postfix.length();) {
+        size_t end = regexTokenEnd(postfix, i);
+        std::string token = postfix.substr(i, end - i);
+        char c = postfix[i];
+        i = end;
+
+        if (c == '.' || c == '|') {
+            if (stack.size() < 2) throw std::runtime_error("malformed regex (stack underflow on " + token + ")");
+            Facts s = stack.back();
+            stack.pop_back();
+            stack.back() = (c == '.') ? concat(stack.back(), s) : alternate(stack.back(), s);
+        } else if (c == '*' || c == '+') {
+            if (stack.empty()) throw std::runtime_error("malformed regex (stack underflow on " + token + ")");
+            stack.back() = repeat(stack.back(), c == '*' ? 0 : 1, -1);
+        } else if (c == '{') {
+            int min, max;
+            if (stack.empty() || !parseRepeat(token, min, max)) {
+                throw std::runtime_error("malformed regex (invalid repetition " + token + ")");
+            }
+            stack.back() = repeat(stack.back(), min, max);
+        } else if (c == '[') {
+            stack.push_back(utf8 ? codePointClass(parseCodePointClass(token)) : byteClass(parseCharacterClass(token)));
+        } else {
+            std::bitset<256> bytes;
+            bytes.set(static_cast<unsigned char>(c == '\\' && token.length() == 2 ? token[1] : c));
+            stack.push_back(byteClass(bytes));
+        }
+    }
+    if (stack.size() != 1) throw std::runtime_error("malformed regex");
+
+    const Facts& facts = stack.back();
+    PatternAnalysis analysis;
+    analysis.minLength = facts.min;
+    analysis.maxLength = facts.max;
+    analysis.firstBytes = facts.first;
+    analysis.requiredBytes = facts.required;
+
+    std::vector<int> required;
+    for (int b = 0; b < 256; b++) {
+        if (facts.required.test(b)) required.push_back(b);
+    }
+    std::stable_sort(required.begin(), required.end(), [](int x, int y) { return rarityRank(x) < rarityRank(y); });
+    for (int b : required) {
+        if (analysis.scanCount == PatternAnalysis::MAX_SCANS) break;
+        analysis.scanBytes[analysis.scanCount++] = static_cast<uint8_t>(b);
+    }
+    return analysis;
+}
+
+std::string PatternAnalysis::describe() const {
+    if (minLength == UNBOUNDED) return "matches nothing";
+    std::string text = "length " + std::to_string(minLength) + ".." +
+                       (maxLength == UNBOUNDED ? std::string("inf") : std::to_string(maxLength));
+    text += ", " + std::to_string(firstBytes.count()) + " first bytes";
+    if (requiredBytes.any()) {
+        text += ", requires";
+        for (int b = 0; b < 256; b++) {
+            if (requiredBytes.test(b)) text += " " + byteName(b);
+        }
+    }
+    return text;
+}
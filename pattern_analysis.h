@@ -0,0 +1,76 @@
+#ifndef PATTERN_ANALYSIS_H
+#define PATTERN_ANALYSIS_H
+
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/**
+ * FILE: pattern_analysis.h
+ * DESCRIPTION: Static facts about a regex, used to reject inputs before matching
+ * PROCESS:
+ *
+ *   Any automaton reads every byte of an input it ends up rejecting. A few
+ *   facts computed once from the pattern reject most such inputs for the
+ *   cost of a comparison or a memchr:
+ *
+ *   1. analyzePattern(postfix[, utf8]): one pass over the postfix regex,
+ *      combining per-operator facts on a stack
+ *      - minLength / maxLength (UNBOUNDED under * + {n,}) in bytes:
+ *          r.s   sum           r|s   min / max
+ *          r*    0 / unbounded r{n,m}  n * min / m * max
+ *      - firstBytes: bytes a non-empty match can start with; r.s adds
+ *        first(s) only when r matches ε
+ *      - requiredBytes: bytes every match contains; a one-byte class is
+ *        required, r.s unites, r|s intersects, r* and r{0,m} require none
+ *      - With --utf8 a class counts its UTF-8 encodings: 1..4 bytes, lead
+ *        bytes only as first bytes, all bytes of a single code point required
+ *      - Every fact is conservative (minLength never too large, firstBytes
+ *        never too small, ...), so a rejection is always right
+ *      - A class matching nothing gives minLength = UNBOUNDED, maxLength = 0
+ *      - Throws std::runtime_error on a malformed postfix
+ *
+ *   2. mayMatch(data, size): false only if no match is possible
+ *      - O(1): length outside [minLength, maxLength], or a first byte that
+ *        no match starts with
+ *      - Then one memchr (SIMD in any libc worth the name) per scan byte:
+ *        up to MAX_SCANS required bytes, picked by a fixed guess at rarity
+ *        (punctuation and upper case before digits, lower case and space).
+ *        memchr stops at the first hit, so a common required byte costs
+ *        little and a rare missing one rejects the whole input in one pass
+ *
+ *   3. selective(): whether mayMatch() can reject anything at all; .* and
+ *      friends skip the prefilter
+ */
+
+struct PatternAnalysis {
+    static constexpr size_t UNBOUNDED = SIZE_MAX;
+    static constexpr int MAX_SCANS = 3;
+
+    size_t minLength = 0;
+    size_t maxLength = UNBOUNDED;
+    std::bitset<256> firstBytes;     // Bytes a non-empty match can start with
+    std::bitset<256> requiredBytes;  // Bytes every match contains
+    int scanCount = 0;
+    uint8_t scanBytes[MAX_SCANS] = {};
+
+    bool selective() const { return minLength > 0 || maxLength != UNBOUNDED || !firstBytes.all() || scanCount > 0; }
+
+    bool mayMatch(const char* data, size_t size) const {
+        if (size < minLength || size > maxLength) return false;
+        if (size == 0) return true;
+        if (!firstBytes.test(static_cast<unsigned char>(data[0]))) return false;
+        for (int k = 0; k < scanCount; k++) {
+            if (!std::memchr(data, scanBytes[k], size)) return false;
+        }
+        return true;
+    }
+
+    std::string describe() const;  // "length 4..inf, 4 first bytes, requires 'T' 'A'"
+};
+
+PatternAnalysis analyzePattern(const std::string& postfix, bool utf8 = false);
+
+#endif
@@ -0,0 +1,110 @@
+#!/usr/bin/env bash
+#
+# FILE: pgo/run_pgo.sh
+# DESCRIPTION: Profile-guided optimization workflow with a gain report
+# PROCESS:
+#   1. Baseline build      (build-pgo-base, Release, no profile)
+#   2. Instrumented build  (build-pgo, ATFL_PGO=GENERATE)
+#   3. Training: the atfl CLI matches the bundled corpora (DNA reads, log
+#      lines, identifier lists) against representative patterns
+#   4. Optimized build     (same build-pgo tree reconfigured with ATFL_PGO=USE,
+#      so GCC finds the .gcda files under the object paths it recorded)
+#   5. Both binaries run the same workload on corpora scaled up SCALE times;
+#      best of RUNS wall times per workload, gain = base / pgo - 1
+#
+# usage: pgo/run_pgo.sh [extra cmake args...]
+#   SCALE=100 RUNS=3 CXX=clang++ pgo/run_pgo.sh -DATFL_NATIVE=ON
+
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+CORPUS="$ROOT/pgo/corpus"
+BASE="$ROOT/build-pgo-base"
+PGO="$ROOT/build-pgo"
+PROFILES="$PGO/profiles"
+DATA="$PGO/data"
+SCALE="${SCALE:-100}"
+RUNS="${RUNS:-3}"
+JOBS="$(nproc 2>/dev/null || echo 4)"
+
+# pattern<TAB>corpus file
+WORKLOAD=(
+    "[ACGT]{50,500}	dna_reads.txt"
+    "[ACGT]*TATA[AT]A[AT][ACGT]*	dna_reads.txt"
+    "[0-9]{4}-[0-9]{2}-[0-9]{2} [0-9:]+ (INFO|WARN|ERROR) [a-z]+: .*	log_lines.txt"
+    ".*(ERROR|WARN).*	log_lines.txt"
+    "[a-zA-Z][a-zA-Z0-9]*	identifiers.txt"
+    "[a-zA-Z_][a-zA-Z0-9_]*	identifiers.txt"
+)
+
+configure() {
+    local dir="$1"; shift
+    mkdir -p "$dir"
+    cmake -S "$ROOT" -B "$dir" -DCMAKE_BUILD_TYPE=Release -DATFL_BUILD_GUI=OFF \
+          -DATFL_BUILD_TESTS=OFF -DATFL_BUILD_FUZZER=OFF "$@" > "$dir/build.log"
+    cmake --build "$dir" -j"$JOBS" --target atfl atfl_benchmark >> "$dir/build.log"
+}
+
+run_workload() {
+    local atfl="$1" data="$2"
+    for entry in "${WORKLOAD[@]}"; do
+        "$atfl" match -c "${entry%%	*}" "$data/${entry##*	}" > /dev/null || true
+    done
+}
+
+# Best wall time in milliseconds of one workload entry
+time_entry() {
+    local atfl="$1" pattern="$2" file="$3" best=""
+    for _ in $(seq "$RUNS"); do
+        local start end
+        start=$(date +%s%N)
+        "$atfl" match -c "$pattern" "$file" > /dev/null || true
+        end=$(date +%s%N)
+        local ms=$(( (end - start) / 1000000 ))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+    done
+    echo "$best"
+}
+
+echo "== Baseline build"
+configure "$BASE" -DATFL_PGO=OFF "$@"
+
+echo "== Instrumented build"
+rm -rf "$PROFILES"
+mkdir -p "$PGO" "$PROFILES"
+configure "$PGO" -DATFL_PGO=GENERATE -DATFL_PGO_DIR="$PROFILES" "$@"
+
+echo "== Training on $CORPUS"
+run_workload "$PGO/atfl" "$CORPUS"
+"$PGO/atfl_benchmark" 20000 > /dev/null
+if ls "$PROFILES"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -o "$PROFILES/merged.profdata" "$PROFILES"/*.profraw
+fi
+
+echo "== Optimized build"
+configure "$PGO" -DATFL_PGO=USE -DATFL_PGO_DIR="$PROFILES" "$@"
+
+echo "== Scaling corpora x$SCALE"
+mkdir -p "$DATA"
+for file in "$CORPUS"/*.txt; do
+    name="$(basename "$file")"
+    : > "$DATA/$name"
+    for _ in $(seq "$SCALE"); do cat "$file" >> "$DATA/$name"; done
+done
+
+echo
+printf "%-64s %10s %10s %8s\n" "workload" "base ms" "pgo ms" "gain"
+total_base=0
+total_pgo=0
+for entry in "${WORKLOAD[@]}"; do
+    pattern="${entry%%	*}"
+    file="$DATA/${entry##*	}"
+    base_ms=$(time_entry "$BASE/atfl" "$pattern" "$file")
+    pgo_ms=$(time_entry "$PGO/atfl" "$pattern" "$file")
+    total_base=$((total_base + base_ms))
+    total_pgo=$((total_pgo + pgo_ms))
+    gain=$(awk -v b="$base_ms" -v p="$pgo_ms" 'BEGIN { if (p > 0) printf "%+.1f%%", (b / p - 1) * 100; else print "n/a" }')
+    printf "%-64s %10d %10d %8s\n" "${pattern:0:40} (${entry##*	})" "$base_ms" "$pgo_ms" "$gain"
+done
+gain=$(awk -v b="$total_base" -v p="$total_pgo" 'BEGIN { if (p > 0) printf "%+.1f%%", (b / p - 1) * 100; else print "n/a" }')
+printf "%-64s %10d %10d %8s\n" "TOTAL" "$total_base" "$total_pgo" "$gain"
@@ -1,175 +1,195 @@
 #include "regex_preprocessor.h"
 #include <stack>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
 #include <cctype>
 
 /**
  * FILE: regex_preprocessor.cpp
  * DESCRIPTION: Implementation of regex preprocessing and postfix conversion
  * PROCESS:
- *   
+ *
  *   preprocessRegex():
- *   - PASS 0: Expand character classes [a-z], [0-9], [^...], \d, \w, \s
- *     Example: [a-z] -> (a|b|c|...|z), [0-9] -> (0|1|2|...|9)
- *   - PASS 1: Iterates through regex, replaces '+' with duplication + '*'
- *     Example: A+ -> AA*, (A|B)+ -> (A|B)(A|B)*
- *   - PASS 2: Scans result, inserts '.' between consecutive operands
- *     Rules: Insert if (prev is alnum/)/\* ) AND (next is alnum/()
+ *   - PASS 1: Tokenize user syntax into internal tokens
+ *     Classes [a-z], [^0-9] are kept verbatim as ONE operand token
+ *     Shorthands: \d -> [0-9], \w -> [A-Za-z0-9_], \s -> [ \t\n\r] (\D \W \S negated)
+ *     Wildcard:   . -> [^] (complement of the empty class = any byte)
+ *     Quantifiers: *, +, ? -> {0,1}, {n}, {n,}, {n,m}; a trailing '?' makes
+ *     the previous quantifier lazy. A quantifier with nothing to repeat, or a
+ *     '{' that does not start a valid bound, is taken as a literal.
+ *     Literal metacharacters are escaped so '.' is free to mean concatenation
+ *     A valid multi-byte UTF-8 literal becomes "(b1.b2...)" so quantifiers
+ *     apply to the whole character
+ *   - PASS 2: Insert '.' between consecutive tokens
+ *     Rules: Insert if (prev is operand/)/quantifier) AND (next is operand/()
+ *
+ *   Class parsing (classRanges):
+ *   - One reader for both byte and UTF-8 classes: items are decoded as bytes
+ *     or as UTF-8 code points, collected as ranges, sorted and merged
+ *   - Negation complements over 0..255 (bytes) or 0..U+10FFFF (code points)
  *
  *   toPostfix():
  *   - Uses operator stack for precedence handling
- *   - Operands (alphanumeric): directly output
- *   - Operators: push/pop based on precedence comparison
+ *   - Operands (literals, escapes, classes): directly output
+ *   - Quantifiers: directly output (postfix unary, highest precedence)
+ *   - Binary operators: push/pop based on precedence comparison
  *   - Parentheses: manage stack for grouping
  */
 
-// Helper function to expand character ranges
-std::string expandCharacterClass(const std::string& classContent, bool negate) {
-    std::string chars = "";
-    
-    // Parse the class content for ranges like a-z or literal chars
-    for (size_t i = 0; i < classContent.length(); i++) {
-        if (i + 2 < classContent.length() && classContent[i + 1] == '-') {
-            // Range detected: a-z, 0-9, etc.
-            char start = classContent[i];
-            char end = classContent[i + 2];
-            for (char c = start; c <= end; c++) {
-                chars += c;
-            }
-            i += 2; // Skip the '-' and end char
-        } else {
-            // Literal character
-            chars += classContent[i];
-        }
+static const std::string META_CHARS = "()|*+?{}.[]\\";
+
+enum class TokenKind { OPERAND, OPEN, CLOSE, UNION, QUANTIFIER };
+
+static std::string literalToken(char c) {
+    if (META_CHARS.find(c) != std::string::npos) return std::string("\\") + c;
+    return std::string(1, c);
+}
+
+// Class body for \d \w \s and their negations, or empty if not a shorthand
+static std::string shorthandClass(char c) {
+    switch (c) {
+        case 'd': return "0-9";
+        case 'w': return "A-Za-z0-9_";
+        case 's': return " \\t\\n\\r";
+        case 'D': return "^0-9";
+        case 'W': return "^A-Za-z0-9_";
+        case 'S': return "^ \\t\\n\\r";
+        default:  return "";
     }
-    
-    if (negate) {
-        // For negation [^...], we'll support only ASCII printable chars (33-126)
-        std::string negatedChars = "";
-        for (char c = 33; c <= 126; c++) {
-            if (chars.find(c) == std::string::npos) {
-                negatedChars += c;
-            }
-        }
-        chars = negatedChars;
+}
+
+static char escapedByte(char c) {
+    if (c == 'n') return '\n';
+    if (c == 't') return '\t';
+    if (c == 'r') return '\r';
+    return c;
+}
+
+// Decodes one UTF-8 code point at pos (bounded by end); invalid bytes read as themselves
+static int decodeUtf8(const std::string& s, size_t& pos, size_t end) {
+    size_t length = utf8SequenceLength(s.data() + pos, end - pos);
+    unsigned char lead = static_cast<unsigned char>(s[pos]);
+    if (length == 1) {
+        pos++;
+        return lead;
     }
-    
-    // Build union: (a|b|c|...)
-    if (chars.empty()) return "";
-    if (chars.length() == 1) return std::string(1, chars[0]);
-    
-    std::string result = "(";
-    for (size_t i = 0; i < chars.length(); i++) {
-        result += chars[i];
-        if (i < chars.length() - 1) result += "|";
+
+    int cp = lead & (0x7F >> length);
+    for (size_t k = 1; k < length; k++) cp = (cp << 6) | (static_cast<unsigned char>(s[pos + k]) & 0x3F);
+    pos += length;
+    return cp;
+}
+
+// Recognize {n}, {n,} or {n,m} at position i; returns false if it is not a bound
+static bool scanRepeat(const std::string& regex, size_t i, size_t& end, std::string& token) {
+    size_t j = i + 1;
+    size_t digits = 0;
+    while (j < regex.length() && isdigit(static_cast<unsigned char>(regex[j]))) { j++; digits++; }
+    if (digits == 0 || digits > 6 || j >= regex.length()) return false;
+
+    if (regex[j] == ',') {
+        j++;
+        size_t maxDigits = 0;
+        while (j < regex.length() && isdigit(static_cast<unsigned char>(regex[j]))) { j++; maxDigits++; }
+        if (maxDigits > 6) return false;
     }
-    result += ")";
-    return result;
+    if (j >= regex.length() || regex[j] != '}') return false;
+
+    end = j;
+    token = regex.substr(i, j - i + 1);
+    return true;
 }
 
 std::string preprocessRegex(std::string regex) {
-    // PASS 0: Expand character classes and escape sequences
-    std::string withClasses = "";
+    // PASS 1: Tokenize into the internal form
+    std::vector<std::string> tokens;
+    std::vector<TokenKind> kinds;
+    auto emit = [&](const std::string& token, TokenKind kind) {
+        tokens.push_back(token);
+        kinds.push_back(kind);
+    };
+    auto canRepeat = [&]() {
+        return !kinds.empty() && kinds.back() != TokenKind::OPEN && kinds.back() != TokenKind::UNION;
+    };
+
     for (size_t i = 0; i < regex.length(); i++) {
         char c = regex[i];
-        
-        // Handle escape sequences
-        if (c == '\\' && i + 1 < regex.length()) {
-            char next = regex[i + 1];
-            if (next == 'd') {
-                // \d -> [0-9]
-                withClasses += "(0|1|2|3|4|5|6|7|8|9)";
-                i++;
-            } else if (next == 'w') {
-                // \w -> [A-Za-z0-9_]
-                withClasses += "(A|B|C|D|E|F|G|H|I|J|K|L|M|N|O|P|Q|R|S|T|U|V|W|X|Y|Z|a|b|c|d|e|f|g|h|i|j|k|l|m|n|o|p|q|r|s|t|u|v|w|x|y|z|0|1|2|3|4|5|6|7|8|9|_)";
-                i++;
-            } else if (next == 's') {
-                // \s -> [ \t\n\r]
-                withClasses += "( )"; // Simplified: just space
-                i++;
-            } else {
-                // Unknown escape, keep literal
-                withClasses += c;
+
+        if (c == '\\') {
+            if (i + 1 >= regex.length()) {
+                emit(literalToken(c), TokenKind::OPERAND);
+                continue;
             }
+            char next = regex[++i];
+            std::string shorthand = shorthandClass(next);
+            if (!shorthand.empty()) emit("[" + shorthand + "]", TokenKind::OPERAND);
+            else emit(literalToken(escapedByte(next)), TokenKind::OPERAND);
         }
-        // Handle character classes [...]
         else if (c == '[') {
-            size_t end = regex.find(']', i + 1);
-            if (end != std::string::npos) {
-                std::string classContent = regex.substr(i + 1, end - i - 1);
-                bool negate = false;
-                
-                // Check for negation [^...]
-                if (!classContent.empty() && classContent[0] == '^') {
-                    negate = true;
-                    classContent = classContent.substr(1);
-                }
-                
-                withClasses += expandCharacterClass(classContent, negate);
-                i = end; // Skip to closing ]
+            size_t j = i + 1;
+            if (j < regex.length() && regex[j] == '^') j++;
+            while (j < regex.length() && regex[j] != ']') j += (regex[j] == '\\') ? 2 : 1;
+
+            if (j < regex.length()) {
+                emit(regex.substr(i, j - i + 1), TokenKind::OPERAND);
+                i = j; // Skip to closing ]
             } else {
-                withClasses += c; // Malformed, keep literal
+                emit(literalToken(c), TokenKind::OPERAND); // Malformed, keep literal
             }
-        } else {
-            withClasses += c;
         }
-    }
-    
-    regex = withClasses;
-    
-    // PASS 1: Expand '+' operator (Syntactic Sugar)
-    // A+ -> AA*
-    // (A|B)+ -> (A|B)(A|B)*
-    std::string expanded = "";
-    for (size_t i = 0; i < regex.length(); i++) {
-        char c = regex[i];
-        if (c == '+') {
-            if (expanded.empty()) continue;
-            char prev = expanded.back();
-           
-            if (prev == ')') {
-                // Duplicate group: find matching '('
-                int depth = 1;
-                int j = expanded.length() - 2;
-                while (j >= 0 && depth > 0) {
-                    if (expanded[j] == ')') depth++;
-                    else if (expanded[j] == '(') depth--;
-                   
-                    if (depth == 0) break;
-                    j--;
-                }
-               
-                if (depth == 0 && j >= 0) {
-                    std::string group = expanded.substr(j);
-                    expanded += group;
-                    expanded += '*';
-                }
+        else if (utf8SequenceLength(regex.data() + i, regex.length() - i) > 1) {
+            size_t length = utf8SequenceLength(regex.data() + i, regex.length() - i);
+            emit("(", TokenKind::OPEN);
+            for (size_t k = 0; k < length; k++) emit(literalToken(regex[i + k]), TokenKind::OPERAND);
+            emit(")", TokenKind::CLOSE);
+            i += length - 1;
+        }
+        else if (c == '.') {
+            emit("[^]", TokenKind::OPERAND);
+        }
+        else if (c == '(') {
+            emit("(", TokenKind::OPEN);
+        }
+        else if (c == ')') {
+            emit(")", TokenKind::CLOSE);
+        }
+        else if (c == '|') {
+            emit("|", TokenKind::UNION);
+        }
+        else if (c == '?' && !kinds.empty() && kinds.back() == TokenKind::QUANTIFIER
+                 && tokens.back().back() != '?') {
+            tokens.back() += '?'; // Lazy quantifier
+        }
+        else if ((c == '*' || c == '+' || c == '?') && canRepeat()) {
+            emit(c == '?' ? "{0,1}" : std::string(1, c), TokenKind::QUANTIFIER);
+        }
+        else if (c == '{') {
+            size_t end;
+            std::string bound;
+            if (canRepeat() && scanRepeat(regex, i, end, bound)) {
+                emit(bound, TokenKind::QUANTIFIER);
+                i = end;
             } else {
-                // Simple char: A -> AA*
-                expanded += prev;
-                expanded += '*';
+                emit(literalToken(c), TokenKind::OPERAND);
             }
-        } else {
-            expanded += c;
+        }
+        else {
+            emit(literalToken(c), TokenKind::OPERAND);
         }
     }
 
     // PASS 2: Insert Explicit Concatenation '.'
     std::string res = "";
-    for (size_t i = 0; i < expanded.length(); i++) {
-        char c = expanded[i];
-        res += c;
-       
-        if (i + 1 < expanded.length()) {
-            char next = expanded[i + 1];
-           
-            // Insert dot between operands
-            // Left can produce: literal, ), or *
-            // Right can consume: literal or (
-            
-            bool leftProduces = (c != '|' && c != '(');  // anything except | and (
-            bool rightConsumes = (next != '|' && next != '*' && next != ')');  // anything except operators and )
-           
+    for (size_t i = 0; i < tokens.size(); i++) {
+        res += tokens[i];
+
+        if (i + 1 < tokens.size()) {
+            // Left can produce: operand, ), or quantifier
+            // Right can consume: operand or (
+            bool leftProduces = (kinds[i] != TokenKind::UNION && kinds[i] != TokenKind::OPEN);
+            bool rightConsumes = (kinds[i + 1] == TokenKind::OPERAND || kinds[i + 1] == TokenKind::OPEN);
+
             if (leftProduces && rightConsumes) {
                 res += '.';
             }
@@ -179,18 +199,172 @@ std::string preprocessRegex(std::string regex) {
 }
 
 int precedence(char c) {
-    if (c == '*') return 3;
+    if (c == '*' || c == '+' || c == '{') return 3;
     if (c == '.') return 2;
     if (c == '|') return 1;
     return 0;
 }
 
+size_t regexTokenEnd(const std::string& regex, size_t i) {
+    size_t len = regex.length();
+    char c = regex[i];
+
+    if (c == '\\') return std::min(i + 2, len);
+
+    if (c == '[') {
+        size_t j = i + 1;
+        if (j < len && regex[j] == '^') j++;
+        while (j < len && regex[j] != ']') j += (regex[j] == '\\') ? 2 : 1;
+        return std::min(j + 1, len);
+    }
+
+    size_t end = i + 1;
+    if (c == '{') {
+        size_t close = regex.find('}', i);
+        end = (close == std::string::npos) ? len : close + 1;
+    }
+    if (c == '*' || c == '+' || c == '{') {
+        if (end < len && regex[end] == '?') end++; // Lazy suffix
+    }
+    return end;
+}
+
+static std::vector<CodePointRange> classRanges(const std::string& token, bool utf8) {
+    std::vector<CodePointRange> ranges;
+    size_t i = 1;
+    size_t end = token.length() - 1; // Position of closing ]
+    bool negate = false;
+
+    if (i < end && token[i] == '^') {
+        negate = true;
+        i++;
+    }
+
+    // Reads one class item; returns -1 if it was a shorthand (already added)
+    auto readItem = [&](size_t& pos) -> int {
+        if (token[pos] != '\\' || pos + 1 >= end) {
+            return utf8 ? decodeUtf8(token, pos, end) : static_cast<unsigned char>(token[pos++]);
+        }
+
+        pos++;
+        if (utf8 && static_cast<unsigned char>(token[pos]) >= 0x80) return decodeUtf8(token, pos, end);
+        char next = token[pos++];
+        std::string shorthand = shorthandClass(next);
+        if (shorthand.empty()) return static_cast<unsigned char>(escapedByte(next));
+        std::vector<CodePointRange> nested = classRanges("[" + shorthand + "]", utf8);
+        ranges.insert(ranges.end(), nested.begin(), nested.end());
+        return -1;
+    };
+
+    while (i < end) {
+        int low = readItem(i);
+        if (low < 0) continue;
+
+        if (i + 1 < end && token[i] == '-') {
+            // Range detected: a-z, 0-9, etc.
+            size_t rangeEnd = i + 1;
+            int high = readItem(rangeEnd);
+            if (high >= 0) {
+                if (low <= high) ranges.push_back({low, high});
+                i = rangeEnd;
+                continue;
+            }
+        }
+        ranges.push_back({low, low});
+    }
+
+    std::sort(ranges.begin(), ranges.end(),
+              [](const CodePointRange& a, const CodePointRange& b) { return a.lo < b.lo; });
+    std::vector<CodePointRange> merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && r.lo <= merged.back().hi + 1) merged.back().hi = std::max(merged.back().hi, r.hi);
+        else merged.push_back(r);
+    }
+    if (!negate) return merged;
+
+    std::vector<CodePointRange> complement;
+    int next = 0;
+    for (const auto& r : merged) {
+        if (r.lo > next) complement.push_back({next, r.lo - 1});
+        next = r.hi + 1;
+    }
+    int top = utf8 ? MAX_CODE_POINT : 0xFF;
+    if (next <= top) complement.push_back({next, top});
+    return complement;
+}
+
+std::bitset<256> parseCharacterClass(const std::string& token) {
+    std::bitset<256> bytes;
+    for (const auto& r : classRanges(token, false)) {
+        for (int c = r.lo; c <= r.hi; c++) bytes.set(c);
+    }
+    return bytes;
+}
+
+std::vector<CodePointRange> parseCodePointClass(const std::string& token) {
+    return classRanges(token, true);
+}
+
+size_t utf8SequenceLength(const char* data, size_t size) {
+    unsigned char lead = static_cast<unsigned char>(data[0]);
+    size_t length;
+    int min;
+    if (lead >= 0xC2 && lead <= 0xDF) { length = 2; min = 0x80; }
+    else if (lead >= 0xE0 && lead <= 0xEF) { length = 3; min = 0x800; }
+    else if (lead >= 0xF0 && lead <= 0xF4) { length = 4; min = 0x10000; }
+    else return 1;
+    if (length > size) return 1;
+
+    int cp = lead & (0x7F >> length);
+    for (size_t k = 1; k < length; k++) {
+        unsigned char b = static_cast<unsigned char>(data[k]);
+        if ((b & 0xC0) != 0x80) return 1;
+        cp = (cp << 6) | (b & 0x3F);
+    }
+    // Reject overlong forms, surrogates and values above U+10FFFF
+    if (cp < min || (cp >= 0xD800 && cp <= 0xDFFF) || cp > MAX_CODE_POINT) return 1;
+    return length;
+}
+
+void encodeUtf8(int cp, int out[4], int& length) {
+    if (cp < 0x80) { out[0] = cp; length = 1; return; }
+    if (cp < 0x800) { out[0] = 0xC0 | (cp >> 6); length = 2; }
+    else if (cp < 0x10000) { out[0] = 0xE0 | (cp >> 12); length = 3; }
+    else { out[0] = 0xF0 | (cp >> 18); length = 4; }
+    for (int k = 1; k < length; k++) out[k] = 0x80 | ((cp >> (6 * (length - 1 - k))) & 0x3F);
+}
+
+bool parseRepeat(const std::string& token, int& min, int& max) {
+    size_t comma = token.find(',');
+    size_t close = token.find('}');
+    if (token.empty() || token[0] != '{' || close == std::string::npos) return false;
+
+    try {
+        if (comma == std::string::npos) {
+            min = max = std::stoi(token.substr(1, close - 1));
+        } else {
+            min = std::stoi(token.substr(1, comma - 1));
+            std::string upper = token.substr(comma + 1, close - comma - 1);
+            max = upper.empty() ? -1 : std::stoi(upper);
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return min >= 0 && (max < 0 || max >= min);
+}
+
 std::string toPostfix(std::string regex) {
     std::string postfix = "";
     std::stack<char> opStack;
-    for (char c : regex) {
-        if (c == '.' || c == '|' || c == '*') {
-            // It's an operator
+    for (size_t i = 0; i < regex.length(); ) {
+        size_t end = regexTokenEnd(regex, i);
+        char c = regex[i];
+
+        if (c == '*' || c == '+' || c == '{') {
+            // Postfix unary quantifier: its operand is already in the output
+            postfix += regex.substr(i, end - i);
+        } else if (c == '.' || c == '|') {
+            // It's a binary operator
             while (!opStack.empty() && precedence(opStack.top()) >= precedence(c)) {
                 postfix += opStack.top();
                 opStack.pop();
@@ -207,9 +381,10 @@ std::string toPostfix(std::string regex) {
                 opStack.pop();
             }
         } else {
-            // It's a literal operand (any character that's not an operator or paren)
-            postfix += c;
+            // It's an operand: literal, escaped literal or character class
+            postfix += regex.substr(i, end - i);
         }
+        i = end;
     }
     while (!opStack.empty()) {
         postfix += opStack.top();
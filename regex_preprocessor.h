@@ -2,25 +2,57 @@
 #define REGEX_PREPROCESSOR_H
 
 #include <string>
+#include <bitset>
+#include <vector>
+#include <cstddef>
 
 /**
  * FILE: regex_preprocessor.h
  * DESCRIPTION: Regex preprocessing and infix-to-postfix conversion
  * PROCESS:
- *   1. preprocessRegex() - Two-pass preprocessing:
- *      - PASS 1: Expands '+' operator (A+ -> AA*, (A|B)+ -> (A|B)(A|B)*)
- *      - PASS 2: Inserts explicit concatenation dots between operands
- *   
+ *   1. preprocessRegex() - Rewrites user syntax into the internal token form:
+ *      - Character classes stay compact: [a-z], \d -> [0-9], . -> [^] (any byte)
+ *      - Metacharacters used as literals are escaped: \. \* \( ...
+ *      - ? -> {0,1};  {n}, {n,}, {n,m} are kept as single repetition tokens
+ *      - A '?' directly after a quantifier marks it lazy: *?  +?  {0,1}?  {2,5}?
+ *      - A multi-byte UTF-8 character is grouped as one operand: é+ repeats
+ *        both bytes of é, not only the last one
+ *      - Inserts explicit concatenation dots between operands
+ *
  *   2. toPostfix() - Shunting-yard algorithm:
  *      - Converts infix regex notation to postfix (RPN)
- *      - Respects operator precedence: * (3) > . (2) > | (1)
+ *      - Quantifiers (*, +, {n,m}) are unary postfix: emitted immediately
+ *      - Respects operator precedence: quantifiers (3) > . (2) > | (1)
  *      - Handles parentheses grouping
- * 
+ *
  *   3. precedence() - Helper to determine operator priority
+ *
+ *   4. Token helpers shared with Thompson's construction:
+ *      - regexTokenEnd(): end of the internal token starting at i
+ *      - parseCharacterClass(): "[...]" token -> set of matching bytes
+ *      - parseCodePointClass(): "[...]" token read as UTF-8 -> sorted, merged
+ *        code-point ranges; negation complements over U+0000..U+10FFFF
+ *      - utf8SequenceLength(): length of the UTF-8 sequence at data (1 if invalid)
+ *      - encodeUtf8(): code point -> its 1..4 UTF-8 bytes
+ *      - parseRepeat(): "{n,m}" token -> bounds (max = -1 if unbounded)
  */
 
+struct CodePointRange {
+    int lo;
+    int hi;  // Inclusive
+};
+
+static constexpr int MAX_CODE_POINT = 0x10FFFF;
+
 std::string preprocessRegex(std::string regex);
 int precedence(char c);
 std::string toPostfix(std::string regex);
 
+size_t regexTokenEnd(const std::string& regex, size_t i);
+std::bitset<256> parseCharacterClass(const std::string& token);
+std::vector<CodePointRange> parseCodePointClass(const std::string& token);
+size_t utf8SequenceLength(const char* data, size_t size);
+void encodeUtf8(int cp, int out[4], int& length);
+bool parseRepeat(const std::string& token, int& min, int& max);
+
 #endif
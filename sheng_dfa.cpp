@@ -0,0 +1,99 @@
+#include "sheng_dfa.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define SHENG_X86 1
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHENG_TARGET
+#else
+#define SHENG_TARGET __attribute__((target("ssse3")))
+#endif
+#endif
+
+/**
+ * FILE: sheng_dfa.cpp
+ * DESCRIPTION: Construction and matching for the shuffle-based DFA
+ * PROCESS:
+ *
+ *   buildSheng():
+ *   - State s of the DFA becomes lane s + 1; DEAD_STATE becomes lane 0
+ *   - masks[b][0] = 0 (dead stays dead), masks[b][s + 1] = next(s, b) + 1
+ *   - Lanes above n are never reached and stay 0
+ *
+ *   shengMatches():
+ *   - shengSimd(): eight shuffles per iteration, then one lane extract to
+ *     test for the dead state; the tail runs one shuffle per byte
+ *   - shengScalar(): the same masks as a byte table
+ *   - hasSsse3() is evaluated once (CPUID)
+ */
+
+bool buildSheng(const DFA& dfa, ShengDFA& sheng) {
+    int n = dfa.stateCount();
+    if (n + 1 > ShengDFA::MAX_STATES) return false;
+
+    sheng.masks.assign(256 * ShengDFA::MAX_STATES, 0);
+    sheng.acceptMask = 0;
+    for (int s = 0; s < n; s++) {
+        for (int c = 0; c < 256; c++) {
+            int t = dfa.next(s, static_cast<unsigned char>(c));
+            sheng.masks[c * ShengDFA::MAX_STATES + s + 1] = static_cast<uint8_t>(t + 1);
+        }
+        if (dfa.isAccepting(s)) sheng.acceptMask |= static_cast<uint16_t>(1u << (s + 1));
+    }
+    sheng.start = static_cast<uint8_t>(n > 0 ? dfa.start + 1 : 0);
+    return true;
+}
+
+static bool shengScalar(const ShengDFA& sheng, const unsigned char* p, size_t size) {
+    const uint8_t* masks = sheng.masks.data();
+    unsigned state = sheng.start;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        for (size_t k = 0; k < 8; k++) state = masks[p[i + k] * ShengDFA::MAX_STATES + state];
+        if (state == 0) return false;
+    }
+    for (; i < size; i++) state = masks[p[i] * ShengDFA::MAX_STATES + state];
+    return (sheng.acceptMask >> state) & 1;
+}
+
+#ifdef SHENG_X86
+SHENG_TARGET
+static bool shengSimd(const ShengDFA& sheng, const unsigned char* p, size_t size) {
+    const __m128i* masks = reinterpret_cast<const __m128i*>(sheng.masks.data());
+    __m128i state = _mm_set1_epi8(static_cast<char>(sheng.start));
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 1]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 2]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 3]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 4]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 5]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 6]), state);
+        state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i + 7]), state);
+        if ((_mm_cvtsi128_si32(state) & 0xFF) == 0) return false;
+    }
+    for (; i < size; i++) state = _mm_shuffle_epi8(_mm_loadu_si128(masks + p[i]), state);
+    return (sheng.acceptMask >> (_mm_cvtsi128_si32(state) & 0xFF)) & 1;
+}
+
+static bool hasSsse3() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+#endif
+
+bool shengMatches(const ShengDFA& sheng, const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef SHENG_X86
+    static const bool simd = hasSsse3();
+    if (simd) return shengSimd(sheng, p, size);
+#endif
+    return shengScalar(sheng, p, size);
+}
@@ -0,0 +1,55 @@
+#ifndef SHENG_DFA_H
+#define SHENG_DFA_H
+
+#include "dfa_construction.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * FILE: sheng_dfa.h
+ * DESCRIPTION: Shuffle-based DFA for automata with at most 16 states (Sheng)
+ * PROCESS:
+ *
+ *   A table DFA step is a dependent load: the next address is only known
+ *   once the previous load returns, so throughput is bounded by L1 latency.
+ *   Sheng keeps the state in a SIMD register instead:
+ *
+ *   1. Layout
+ *      - State 0 is the dead state, the DFA's states are 1..n (n <= 15)
+ *      - masks[b] is a 16-byte vector: lane s holds the next state of s on
+ *        byte b, so one row per byte value (256 x 16 bytes = 4 KiB)
+ *      - acceptMask: bit s set when state s accepts
+ *
+ *   2. Step (SSSE3 PSHUFB)
+ *      - Every lane of the state register holds the current state s
+ *      - state = shuffle(masks[b], state) picks lane s of masks[b] into every
+ *        lane: one 1-cycle shuffle per byte; the mask load depends only on
+ *        the input, not on the previous state
+ *      - The dead state is checked once per 8 bytes
+ *
+ *   3. Dispatch
+ *      - The SSSE3 path is compiled with a function-level target attribute
+ *        and chosen at run time when the CPU supports it, so the default
+ *        build does not need -mssse3
+ *      - Otherwise the same masks are walked as a compact 16-column byte
+ *        table (masks[b][s])
+ *
+ *   4. buildSheng(dfa, sheng): false when the DFA needs more than 15 states;
+ *      compileDFA() (compiled_dfa.h) calls it to pick the engine
+ */
+
+struct ShengDFA {
+    static constexpr int MAX_STATES = 16;  // Including the dead state
+
+    std::vector<uint8_t> masks;  // masks[b * 16 + s] = next state; empty = not built
+    uint8_t start = 0;
+    uint16_t acceptMask = 0;
+
+    bool empty() const { return masks.empty(); }
+};
+
+bool buildSheng(const DFA& dfa, ShengDFA& sheng);
+bool shengMatches(const ShengDFA& sheng, const char* data, size_t size);
+
+#endif
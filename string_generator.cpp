@@ -0,0 +1,144 @@
+#include "string_generator.h"
+#include <algorithm>
+
+/**
+ * FILE: string_generator.cpp
+ * DESCRIPTION: Implementation of path-count based string generation
+ * PROCESS:
+ *
+ *   StringGenerator():
+ *   - Group each DFA row into edges (target, bytes), dropping dead bytes
+ *   - Fill counts for lengths 0..maxLength, one pass over the edges per length
+ *   - Time: O(maxLength * |edges|), memory O(maxLength * |states|)
+ *
+ *   sample():
+ *   - x = uniform in [0, count[length][start]); walk down the edges of the
+ *     current state subtracting edge weights until x falls inside one; the
+ *     remainder x / count[remaining-1][t] then selects the byte
+ *
+ *   nearMiss():
+ *   - Up to 64 attempts: sample an accepted string, apply one random edit,
+ *     keep it if the DFA rejects it; the new byte alternates between the
+ *     automaton's alphabet and any byte, so [ACGT]{50,500} still gets rejects
+ */
+
+StringGenerator::StringGenerator(const DFA& dfa, int maxLength, uint64_t seed)
+    : dfa(dfa), maxLength(maxLength), rng(seed) {
+    int n = dfa.stateCount();
+
+    edgeStart.push_back(0);
+    std::vector<int> targets;
+    for (int s = 0; s < n; s++) {
+        targets.clear();
+        for (int c = 0; c < 256; c++) {
+            int t = dfa.next(s, static_cast<unsigned char>(c));
+            if (t != DFA::DEAD_STATE && std::find(targets.begin(), targets.end(), t) == targets.end()) {
+                targets.push_back(t);
+            }
+        }
+        for (int t : targets) {
+            Edge edge = {t, static_cast<int>(bytes.size()), 0};
+            for (int c = 0; c < 256; c++) {
+                if (dfa.next(s, static_cast<unsigned char>(c)) == t) {
+                    bytes.push_back(static_cast<unsigned char>(c));
+                    edge.byteCount++;
+                }
+            }
+            edges.push_back(edge);
+        }
+        edgeStart.push_back(static_cast<int>(edges.size()));
+    }
+
+    counts.assign(static_cast<size_t>(maxLength + 1) * n, 0.0);
+    for (int s = 0; s < n; s++) counts[s] = dfa.isAccepting(s) ? 1.0 : 0.0;
+    for (int r = 1; r <= maxLength; r++) {
+        double* row = &counts[static_cast<size_t>(r) * n];
+        const double* below = &counts[static_cast<size_t>(r - 1) * n];
+        for (int s = 0; s < n; s++) {
+            double total = 0.0;
+            for (int e = edgeStart[s]; e < edgeStart[s + 1]; e++) {
+                total += edges[e].byteCount * below[edges[e].target];
+            }
+            row[s] = total;
+        }
+    }
+}
+
+double StringGenerator::acceptedCount(int length) const {
+    if (length < 0 || length > maxLength) return 0.0;
+    return count(length, dfa.start);
+}
+
+bool StringGenerator::sample(int length, std::string& out) {
+    out.clear();
+    if (acceptedCount(length) <= 0.0) return false;
+
+    int state = dfa.start;
+    for (int remaining = length; remaining > 0; remaining--) {
+        double x = std::uniform_real_distribution<double>(0.0, count(remaining, state))(rng);
+        const Edge* chosen = nullptr;
+        double weight = 0.0;
+        for (int e = edgeStart[state]; e < edgeStart[state + 1]; e++) {
+            double each = count(remaining - 1, edges[e].target);
+            if (each <= 0.0) continue;
+            chosen = &edges[e];
+            weight = each;
+            if (x < edges[e].byteCount * each) break;
+            x -= edges[e].byteCount * each;
+        }
+
+        // Rounding can push x past the last edge; the last live edge absorbs it
+        int pick = std::min(static_cast<int>(x / weight), chosen->byteCount - 1);
+        out += static_cast<char>(bytes[chosen->byteStart + std::max(pick, 0)]);
+        state = chosen->target;
+    }
+    return true;
+}
+
+void StringGenerator::enumerateFrom(int state, int remaining, std::string& prefix,
+                                    std::vector<std::string>& out, size_t limit) const {
+    if (out.size() >= limit) return;
+    if (remaining == 0) {
+        out.push_back(prefix);
+        return;
+    }
+
+    // Visit bytes in order, not edges, so output is sorted within a length
+    for (int c = 0; c < 256 && out.size() < limit; c++) {
+        int t = dfa.next(state, static_cast<unsigned char>(c));
+        if (t == DFA::DEAD_STATE || count(remaining - 1, t) <= 0.0) continue;
+        prefix.push_back(static_cast<char>(c));
+        enumerateFrom(t, remaining - 1, prefix, out, limit);
+        prefix.pop_back();
+    }
+}
+
+size_t StringGenerator::enumerate(int maxLength, std::vector<std::string>& out, size_t limit) const {
+    size_t before = out.size();
+    limit = (limit > SIZE_MAX - before) ? SIZE_MAX : before + limit;
+    std::string prefix;
+    for (int length = 0; length <= std::min(maxLength, this->maxLength); length++) {
+        if (count(length, dfa.start) > 0.0) enumerateFrom(dfa.start, length, prefix, out, limit);
+    }
+    return out.size() - before;
+}
+
+bool StringGenerator::nearMiss(int length, std::string& out) {
+    std::string accepted;
+    for (int attempt = 0; attempt < 64; attempt++) {
+        if (!sample(length, accepted)) return false;
+
+        out = accepted;
+        // Even attempts stay inside the automaton's alphabet, odd ones may leave it
+        unsigned char byte = (bytes.empty() || attempt % 2 == 1) ? static_cast<unsigned char>(rng())
+                                                                 : bytes[rng() % bytes.size()];
+        size_t at = out.empty() ? 0 : rng() % out.size();
+        switch (out.empty() ? 1 : rng() % 3) {
+            case 0: out[at] = static_cast<char>(byte); break;
+            case 1: out.insert(out.begin() + (out.empty() ? 0 : rng() % (out.size() + 1)), static_cast<char>(byte)); break;
+            default: out.erase(at, 1); break;
+        }
+        if (!dfa.matches(out)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,69 @@
+#ifndef STRING_GENERATOR_H
+#define STRING_GENERATOR_H
+
+#include "dfa_construction.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * FILE: string_generator.h
+ * DESCRIPTION: Automaton-guided generation of accepted and rejected strings
+ * PROCESS:
+ *
+ *   Works on the DFA: every accepted string has exactly one path, so
+ *   counting paths counts strings (NFA paths would over-count ambiguous ones).
+ *
+ *   1. Path counts (constructor)
+ *      - count[0][s] = 1 if s accepts, else 0
+ *      - count[r][s] = sum over edges s -> t of |bytes(edge)| * count[r-1][t]
+ *      - Bytes with the same target are grouped into one edge, so a state
+ *        with a [a-z] loop has 1 edge instead of 26
+ *      - Counts are doubles: exact up to 2^53, relative error 2^-53 beyond
+ *
+ *   2. sample(length) - Uniformly random accepted string of that length
+ *      - At each step pick an edge with probability
+ *        |bytes| * count[remaining-1][t] / count[remaining][s], then a byte
+ *        uniformly inside the edge: O(length * edges per state)
+ *
+ *   3. enumerate(maxLength) - Every accepted string up to maxLength, shortest
+ *      first, in byte order; branches that cannot reach acceptance in the
+ *      remaining steps are never entered
+ *
+ *   4. nearMiss(length) - A rejected string one edit (substitute, insert or
+ *      delete one byte) away from a random accepted string; the new byte
+ *      alternates between the automaton's own alphabet (a close reject) and
+ *      any byte, so languages closed under in-alphabet edits, like
+ *      [ACGT]{50,500}, still get rejects
+ */
+
+class StringGenerator {
+    struct Edge {
+        int target;
+        int byteStart;  // Index into bytes
+        int byteCount;
+    };
+
+    DFA dfa;
+    int maxLength;
+    std::vector<double> counts;       // counts[length * stateCount + state]
+    std::vector<int> edgeStart;       // Edges of s: edges[edgeStart[s] .. edgeStart[s + 1])
+    std::vector<Edge> edges;
+    std::vector<unsigned char> bytes;
+    std::mt19937_64 rng;
+
+    double count(int length, int state) const { return counts[static_cast<size_t>(length) * dfa.stateCount() + state]; }
+    void enumerateFrom(int state, int remaining, std::string& prefix, std::vector<std::string>& out, size_t limit) const;
+
+public:
+    StringGenerator(const DFA& dfa, int maxLength, uint64_t seed = 1);
+
+    double acceptedCount(int length) const;
+    bool sample(int length, std::string& out);
+    size_t enumerate(int maxLength, std::vector<std::string>& out, size_t limit = SIZE_MAX) const;
+    bool nearMiss(int length, std::string& out);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "allocation_counter.h"
+#include <cstdlib>
+#include <new>
+
+/**
+ * FILE: tests/allocation_counter.cpp
+ * DESCRIPTION: Replacement global operator new / delete with a counter
+ * PROCESS:
+ *
+ *   - countedAlloc(): bump the thread-local counter, then malloc (or the
+ *     platform's aligned allocator); size 0 is rounded up to 1 as the
+ *     standard requires a unique pointer
+ *   - Throwing forms raise std::bad_alloc on failure, nothrow forms return
+ *     nullptr; every delete form releases through the matching free
+ *   - thread_local keeps the counter exact when parser and lexer threads
+ *     allocate concurrently (token_pipeline THREADED mode)
+ */
+
+static thread_local size_t allocations = 0;
+
+size_t allocationCount() {
+    return allocations;
+}
+
+static void* countedAlloc(size_t size, size_t alignment = 0) {
+    if (size == 0) size = 1;
+    void* p = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        p = std::malloc(size);
+    } else {
+#ifdef _WIN32
+        p = _aligned_malloc(size, alignment);
+#else
+        if (posix_memalign(&p, alignment, size) != 0) p = nullptr;
+#endif
+    }
+    if (p) allocations++;
+    return p;
+}
+
+static void countedFree(void* p, size_t alignment = 0) {
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(p);
+}
+
+static void* throwingAlloc(size_t size, size_t alignment = 0) {
+    void* p = countedAlloc(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return throwingAlloc(size); }
+void* operator new[](size_t size) { return throwingAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void* operator new(size_t size, std::align_val_t al) { return throwingAlloc(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al) { return throwingAlloc(size, static_cast<size_t>(al)); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return countedAlloc(size, static_cast<size_t>(al));
+}
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return countedAlloc(size, static_cast<size_t>(al));
+}
+
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+void operator delete(void* p, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete(void* p, size_t, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, size_t, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept {
+    countedFree(p, static_cast<size_t>(al));
+}
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept {
+    countedFree(p, static_cast<size_t>(al));
+}
@@ -0,0 +1,37 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+/**
+ * FILE: tests/allocation_counter.h
+ * DESCRIPTION: Global allocator hook counting heap allocations (test mode)
+ * PROCESS:
+ *
+ *   1. allocation_counter.cpp replaces the global operator new / delete
+ *      (plain, array, nothrow and aligned forms); every successful new bumps
+ *      a per-thread counter before forwarding to malloc
+ *      - Only linked into test and benchmark executables, never atfl_core,
+ *        so the library itself keeps the default allocator
+ *
+ *   2. AllocationScope: RAII snapshot of the calling thread's counter
+ *      - count() = allocations made on this thread since construction,
+ *        i.e. the allocations performed by the API calls in the scope
+ *
+ *   usage:
+ *      AllocationScope scope;
+ *      dfa.matches(input);
+ *      CHECK(scope.count() == 0);
+ */
+
+size_t allocationCount();  // Allocations made by the calling thread so far
+
+class AllocationScope {
+    size_t start;
+
+public:
+    AllocationScope() : start(allocationCount()) {}
+    size_t count() const { return allocationCount() - start; }
+};
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * FILE: tests/test_allocations.cpp
+ * DESCRIPTION: Zero-allocation checks for the steady-state hot paths (run by ctest)
+ * PROCESS:
+ *
+ *   Linked with allocation_counter.cpp, which counts every operator new.
+ *   Each test compiles its automaton up front, makes one warm-up call (so
+ *   buffers kept between calls reach their final size), then asserts that
+ *   further calls inside an AllocationScope allocate nothing:
+ *
+ *   1. match:  DFA::matches, minimized and compiled DFA matches, simulateNFA
+ *              on a counter-free NFA, the counting-set simulator with an
+ *              explicit MatchContext and with the thread-local pool, and
+ *              PatternMatcher::matches on the counting-set engine with
+ *              inputs longer than a short string
+ *   2. search: Lexer::next scanning tokens out of a text, a reserved
+ *              EpsilonClosure walker, and subset construction allocating
+ *              per DFA state rather than per closure
+ *   3. parse:  AdaptivePDA::parse over span and byte token sources, and a
+ *              deduplicated AdaptivePDA::parseAll batch
+ *
+ *   simulateNFA on an NFA with counters still steps sets of configurations
+ *   and allocates per character; it is only checked to show the hook is live.
+ */
+
+#include "allocation_counter.h"
+#include "regex_preprocessor.h"
+#include "thompsons_construction.h"
+#include "nfa_simulator.h"
+#include "counting_set_automaton.h"
+#include "match_context.h"
+#include "dfa_construction.h"
+#include "dfa_operations.h"
+#include "compiled_dfa.h"
+#include "match_planner.h"
+#include "lexer_generator.h"
+#include "adaptive_pda.h"
+#include "token_source.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition \
+                      << std::endl;                                                   \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static void testMatch() {
+    NFAFragment nfa = regexToNFA(toPostfix(preprocessRegex("[ACGT]*TATA[AT]A[AT][ACGT]*")));
+    DFA dfa = buildDFA(nfa);
+    DFA minimal = minimizeDFA(dfa);
+    CompiledDFA compiled = compileDFA(minimal);
+    const std::vector<std::string> inputs = {"GGTATAAATCC", "TATATAT", "", "ACGTACGTACGT"};
+
+    size_t hits = dfa.matches(inputs[0]) + minimal.matches(inputs[0]);
+    for (const auto& input : inputs) hits += simulateNFA(nfa, input);  // Sizes its state lists
+    {
+        AllocationScope scope;
+        for (int r = 0; r < 100; r++) {
+            for (const auto& input : inputs) {
+                hits += dfa.matches(input) + minimal.matches(input) + compiled.matches(input) +
+                        simulateNFA(nfa, input);
+            }
+        }
+        CHECK(scope.count() == 0);
+    }
+    CHECK(hits == 4 + 100 * 8);
+
+    // With counters the configuration sets still allocate
+    NFAFragment counted = regexToNFA(toPostfix(preprocessRegex("[ACGT]{2,12}")));
+    AllocationScope scope;
+    CHECK(simulateNFA(counted, inputs[3]));
+    CHECK(scope.count() > 0);
+    StateManager::clear();
+}
+
+static void testMatchContext() {
+    CountingNFA motif = buildCountingNFA(regexToNFA(toPostfix(preprocessRegex("[ACGT]*TATA[AT]A[AT][ACGT]*"))));
+    CountingNFA read = buildCountingNFA(regexToNFA(toPostfix(preprocessRegex("[ACGT]{5,40}"))));
+    CHECK(motif.supported && read.supported);
+    const std::vector<std::string> inputs = {"GGTATAAATCC", "ACGTACGTACGT", "TATATAT", "ACG"};
+
+    // Warm-up: the context is sized for the larger automaton, the pool gets one context
+    MatchContext context;
+    size_t hits = 0;
+    for (const auto& input : inputs) {
+        hits += simulateCountingNFA(motif, input, context) + simulateCountingNFA(read, input, context);
+        hits += simulateCountingNFA(motif, input) + simulateCountingNFA(read, input);
+    }
+    CHECK(hits == 2 * 5);
+
+    AllocationScope scope;
+    for (int r = 0; r < 100; r++) {
+        for (const auto& input : inputs) {
+            hits += simulateCountingNFA(motif, input, context) + simulateCountingNFA(read, input, context);
+            hits += simulateCountingNFA(motif, input) + simulateCountingNFA(read, input);
+        }
+    }
+    CHECK(scope.count() == 0);
+    CHECK(hits == 101 * 2 * 5);
+
+    // The planner's entry point hands the bytes to the simulator as they are
+    PatternMatcher wide("[ACGT]*A[ACGT]{20}");
+    CHECK(wide.plan().engine == MatchEngine::COUNTING);
+    const std::string hit = std::string(100, 'C') + "A" + std::string(20, 'G');
+    const std::string miss = std::string(100, 'C') + "T" + std::string(20, 'G');
+    size_t planned = wide.matches(hit);
+    {
+        AllocationScope planScope;
+        for (int r = 0; r < 100; r++) planned += wide.matches(hit) + wide.matches(miss);
+        CHECK(planScope.count() == 0);
+    }
+    CHECK(planned == 101);
+    StateManager::clear();
+}
+
+static void testSearch() {
+    Lexer lexer({{"KEYWORD", "if|while"}, {"IDENT", "[a-z][a-z0-9]*"},
+                 {"NUMBER", "[0-9]+"}, {"SPACE", " +", true}});
+    const std::string text = "while x1 iffy 42 ?? return if y2";
+
+    size_t tokens = 0;
+    {
+        AllocationScope scope;
+        for (int r = 0; r < 100; r++) {
+            size_t pos = 0;
+            Token token;
+            while (lexer.next(text, pos, token)) tokens++;
+        }
+        CHECK(scope.count() == 0);
+    }
+    CHECK(tokens == 100 * 16);
+    StateManager::clear();
+
+    NFAFragment nfa = regexToNFA(toPostfix(preprocessRegex("(a|b)*a?b?c")));
+    EpsilonClosure walker;
+    walker.reserve();
+    std::vector<NFAState*> closure;
+    closure.reserve(StateManager::getStateCount());
+    size_t reached = 0;
+    {
+        AllocationScope scope;
+        for (int r = 0; r < 100; r++) {
+            closure.clear();
+            walker.begin();
+            walker.add(nfa.start, closure);
+            reached += closure.size();
+        }
+        CHECK(scope.count() == 0);
+    }
+    CHECK(reached > 0 && reached % 100 == 0);
+
+    // Subset construction shares one walker and its buffers: allocations grow
+    // with the DFA states created, not with the closures taken (~100 per state before)
+    NFAFragment window = regexToNFA(toPostfix(preprocessRegex("(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)")));
+    size_t allocations;
+    int states;
+    {
+        AllocationScope scope;
+        states = buildDFA(window).stateCount();
+        allocations = scope.count();
+    }
+    CHECK(states == 257);
+    CHECK(allocations < 3 * static_cast<size_t>(states) + 100);
+    StateManager::clear();
+}
+
+static void testParse() {
+    AdaptivePDA parser;
+    ByteTokenMap map = parser.byteTokenMap();
+    const std::string hairpin = "GGAAG.CTTCC";
+    std::vector<int> ids;
+    for (char c : hairpin) ids.push_back(map[static_cast<unsigned char>(c)]);
+
+    SpanTokenSource warmUp(ids);
+    CHECK(parser.parse(warmUp));
+
+    AllocationScope scope;
+    bool accepted = true;
+    for (int r = 0; r < 100; r++) {
+        SpanTokenSource span(ids);
+        ByteTokenSource bytes(hairpin.data(), hairpin.size(), map);
+        accepted = accepted && parser.parse(span) && parser.parse(bytes);
+    }
+    CHECK(scope.count() == 0);
+    CHECK(accepted);
+
+    const std::vector<std::string> batch = {hairpin, "GA.TC", hairpin, "GG.C", hairpin};
+    std::vector<char> results;
+    parser.parseAll(batch, results, true);
+    {
+        AllocationScope batchScope;
+        for (int r = 0; r < 100; r++) parser.parseAll(batch, results, true);
+        CHECK(batchScope.count() == 0);
+    }
+    CHECK((results == std::vector<char>{1, 1, 1, 0, 1}));
+}
+
+int main() {
+    testMatch();
+    testMatchContext();
+    testSearch();
+    testParse();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
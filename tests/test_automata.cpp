@@ -0,0 +1,401 @@
+/**
+ * FILE: tests/test_automata.cpp
+ * DESCRIPTION: Regression tests for the core library (run by ctest)
+ * PROCESS:
+ *
+ *   Plain CHECK macro, no framework: every failed check prints its location
+ *   and the process exits non-zero.
+ *
+ *   1. Regex engines: NFA, counting-set NFA, DFA, minimized DFA, the
+ *      compiled (premultiplied) DFA, with and without the Sheng engine,
+ *      its native code (where the JIT is available) and the derivative
+ *      matcher agree on a table of (pattern, input, expected) cases
+ *   2. Active-state sets: ActiveStates switches between bitset and sparse
+ *      set, and the counting-set engine runs a large literal automaton;
+ *      ε-closures over a 100000-deep ε-chain (no recursion limit)
+ *   3. UTF-8 classes and DFA language operations
+ *   4. Compiled DFA layouts: byte classes, Sheng, accelerated states,
+ *      8-bit IDs and the row-compressed table
+ *   5. HotDFA: the table until the call threshold, then native code (where
+ *      the JIT is available); Sheng automata stay on Sheng
+ *   6. Derivative matcher: only visited states are built, and a long
+ *      literal is built in linear time
+ *   7. String generator: near misses are one edit away and rejected; their
+ *      new bytes come both from the alphabet and from outside it
+ *   8. Lexer maximal munch and the lexer -> parser pipeline
+ *   9. Engine planner: the engine picked per pattern and workload, and the
+ *      static facts (lengths, first and required bytes) of its prefilter
+ *   10. Batch deduplication: XXH64 reference values, and deduplicated
+ *       matchAll / parseAll agree with the plain batch
+ */
+
+#include "regex_preprocessor.h"
+#include "thompsons_construction.h"
+#include "nfa_simulator.h"
+#include "counting_set_automaton.h"
+#include "match_context.h"
+#include "dfa_construction.h"
+#include "dfa_operations.h"
+#include "compiled_dfa.h"
+#include "dfa_jit.h"
+#include "derivative_matcher.h"
+#include "match_planner.h"
+#include "pattern_analysis.h"
+#include "batch_dedup.h"
+#include "string_generator.h"
+#include "lexer_generator.h"
+#include "adaptive_pda.h"
+#include "token_pipeline.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition \
+                      << std::endl;                                                   \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static DFA compile(const std::string& regex, bool utf8 = false) {
+    return buildDFA(regexToNFA(toPostfix(preprocessRegex(regex)), utf8));
+}
+
+static void testEngines() {
+    struct Case { const char* regex; const char* input; bool expected; };
+    const Case cases[] = {
+        {"(A|G)+", "AGAGA", true},
+        {"(A|G)+", "", false},
+        {"[a-zA-Z][a-zA-Z0-9]*", "counter123", true},
+        {"[a-zA-Z][a-zA-Z0-9]*", "123abc", false},
+        {"[0-9]+(\\.[0-9]+)?", "3.14", true},
+        {"[0-9]+(\\.[0-9]+)?", "3.", false},
+        {"a{3}", "aaa", true},
+        {"a{3}", "aaaa", false},
+        {"[ACGT]{2,4}", "ACG", true},
+        {"[ACGT]{2,4}", "ACGTA", false},
+        {"(ab){2,}", "ababab", true},
+        {"colou?r", "color", true},
+        {"a.c", "abc", true},
+        {"a\\.c", "abc", false},
+        {"\\d+\\s\\w+", "42 items", true},
+        {"[a-zA-Z][a-zA-Z0-9]*", "averyLongIdentifierName0123456789withMoreText", true},
+        {"[a-zA-Z][a-zA-Z0-9]*", "averyLongIdentifierName0123456789_withMoreText", false},
+        {".*(ERROR|WARN).*", "2024-01-01 12:00:00 disk check on /dev/sda1 ERROR no space left", true},
+        {".*(ERROR|WARN).*", "2024-01-01 12:00:00 disk check on /dev/sda1 EROR no space left", false},
+        {"a*b", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", true},
+    };
+
+    for (const auto& c : cases) {
+        NFAFragment nfa = regexToNFA(toPostfix(preprocessRegex(c.regex)));
+        CountingNFA counting = buildCountingNFA(nfa);
+        DFA dfa = buildDFA(nfa);
+        DFA minimal = minimizeDFA(dfa);
+        CompiledDFA compiled = compileDFA(minimal);
+        CompiledDFA table = compiled;
+        table.sheng = ShengDFA();
+        CompiledDFA packed = compileDFA(minimal, 0);
+        packed.sheng = ShengDFA();
+        DFAJit jit;
+        CHECK(jit.compile(compiled) == DFAJit::available());
+        DerivativeMatcher derivative(toPostfix(preprocessRegex(c.regex)));
+
+        CHECK(simulateNFA(nfa, c.input) == c.expected);
+        CHECK(simulateCountingNFA(counting, c.input) == c.expected);
+        CHECK(dfa.matches(c.input) == c.expected);
+        CHECK(minimal.matches(c.input) == c.expected);
+        CHECK(compiled.matches(c.input) == c.expected);
+        CHECK(table.matches(c.input) == c.expected);
+        CHECK(packed.matches(c.input) == c.expected);
+        CHECK(!jit.ready() || jit.matches(c.input, std::strlen(c.input)) == c.expected);
+        CHECK(derivative.matches(c.input) == c.expected);
+        CHECK(compileDFA(dfa).matches(c.input) == c.expected);
+    }
+    StateManager::clear();
+}
+
+static void testActiveStates() {
+    ActiveStates states;
+    states.resize(4096);
+    for (int s : {4095, 7, 64}) CHECK(states.insert(s));
+    CHECK(!states.insert(7) && !states.isSparse());
+    states.clear();  // 3 states out of 64 words: switch to the sparse set
+    CHECK(states.isSparse() && states.empty());
+    for (int s : {4095, 7, 64}) CHECK(states.insert(s));
+    CHECK(!states.insert(64) && states.contains(4095) && !states.contains(8) && states.size() == 3);
+    int sum = 0;
+    states.forEach([&](int s) { sum += s; });
+    CHECK(sum == 4095 + 7 + 64);
+    for (int s = 0; s < 4096; s += 8) states.insert(s);
+    states.clear();  // 514 states: back to the bitset
+    CHECK(!states.isSparse() && !states.contains(7));
+
+    std::string literal;
+    for (int k = 0; k < 200; k++) literal += "acgt"[k * 7 % 4] + std::string("x") + char('a' + k % 26);
+    CountingNFA counting = buildCountingNFA(regexToNFA(toPostfix(preprocessRegex("y?" + literal + "[a-z]*"))));
+    CHECK(counting.stateCount() > 1024);
+    CHECK(simulateCountingNFA(counting, literal + "end"));
+    CHECK(simulateCountingNFA(counting, "y" + literal));
+    CHECK(!simulateCountingNFA(counting, literal.substr(0, 500) + "#" + literal.substr(501)));
+    StateManager::clear();
+
+    std::string chain;
+    for (int k = 0; k < 100000; k++) chain += "a?";
+    NFAFragment deep = regexToNFA(toPostfix(preprocessRegex(chain + "b")));
+    EpsilonClosure walker;
+    walker.reserve();
+    std::vector<NFAState*> closure;
+    walker.begin();
+    walker.add(deep.start, closure);
+    walker.add(deep.start, closure);  // Already visited in this generation
+    bool reachesB = false;
+    for (NFAState* s : closure) reachesB = reachesB || s->transitions.count('b');
+    CHECK(reachesB && closure.size() > 100000);
+    size_t first = closure.size();
+    closure.clear();
+    walker.begin();
+    walker.add(deep.start, closure);
+    CHECK(closure.size() == first);
+    CHECK(simulateNFA(deep, "aaab") && !simulateNFA(deep, "aaa"));
+    StateManager::clear();
+}
+
+static void testUtf8AndOperations() {
+    DFA greek = compile("[α-ω]+", true);
+    CHECK(greek.matches("λόγ") == false);  // ό is outside α-ω
+    CHECK(greek.matches("λογ"));
+    CHECK(compile(".", true).matches("日"));
+    CHECK(!compile(".", false).matches("日"));
+
+    DFA identifiers = compile("[a-z]+");
+    DFA keywords = compile("if|while");
+    DFA names = differenceDFA(identifiers, keywords);
+    CHECK(names.matches("whilst"));
+    CHECK(!names.matches("while"));
+    CHECK(intersectDFA(identifiers, keywords).matches("if"));
+    CHECK(complementDFA(keywords).matches("iff"));
+
+    CHECK(checkEquivalence(compile("(a|b)*abb"), compile("(a*b*)*abb")).holds);
+    LanguageCheck diff = checkEquivalence(compile("a*"), compile("(aa)*"));
+    CHECK(!diff.holds && diff.counterexample == "a");
+    CHECK(checkInclusion(compile("(aa)*"), compile("a*")).holds);
+    StateManager::clear();
+}
+
+static void testCompiledLayouts() {
+    CompiledDFA dna = compileDFA(minimizeDFA(compile("[ACGT]+")));
+    CHECK(dna.classCount == 2);  // {A,C,G,T} and everything else
+    CHECK(dna.isAccepting(dna.next(dna.start, 'G')));
+    CHECK(dna.next(dna.start, 'x') == CompiledDFA::DEAD);
+    CHECK(!dna.sheng.empty());
+    CHECK(!compileDFA(minimizeDFA(compile("(A|G)+"))).sheng.empty());
+    CompiledDFA tail = compileDFA(minimizeDFA(compile("[a-zA-Z][a-zA-Z0-9]*")));
+    CHECK(tail.isAccelerated(tail.next(tail.start, 'x')));
+    CHECK(tail.skip(tail.next(tail.start, 'x'), reinterpret_cast<const unsigned char*>("abcDEF0123456789xyz;"), 20) == 19);
+    CompiledDFA packed = compileDFA(minimizeDFA(compile("[a-zA-Z][a-zA-Z0-9]*")), 0);
+    CHECK(tail.idBytes == 1 && tail.layout == CompiledDFA::DENSE);
+    CHECK(packed.layout == CompiledDFA::ROW_COMPRESSED);
+    int tag = -1;
+    CHECK(packed.longestMatch("abc1 x", 6, tag) == 4 && tag == 0);
+    CHECK(packed.longestMatch("1abc", 4, tag) == 0 && tag == -1);
+    StateManager::clear();
+}
+
+static void testHotDFA() {
+    HotDFA hot(compileDFA(minimizeDFA(compile("[a-zA-Z][a-zA-Z0-9]*"))), 2);
+    CHECK(hot.matches("abc1") && !hot.matches("1abc") && !hot.jitted());
+    CHECK(hot.matches("x") && hot.jitted() == DFAJit::available());
+    CHECK(hot.matches("averyLongIdentifierName0123456789") && !hot.matches("a_b"));
+
+    HotDFA small(compileDFA(minimizeDFA(compile("[ACGT]+"))), 0);
+    CHECK(small.matches("GATTACA") && !small.jitted());  // Stays on Sheng
+    StateManager::clear();
+}
+
+static void testDerivativeMatcher() {
+    // Only the states the inputs visit are built: 3 of a{1000}'s 1001 + dead
+    DerivativeMatcher lazy(toPostfix(preprocessRegex("a{1000}b|c")));
+    CHECK(!lazy.matches("aa") && lazy.stateCount() == 3);
+    CHECK(lazy.matches("c") && !lazy.matches("ab") && lazy.matches(std::string(1000, 'a') + "b"));
+    CHECK(!lazy.matches(std::string(999, 'a') + "b") && lazy.stateCount() < 1010);
+
+    // A long literal is built and derived in linear time (was quadratic, with recursion as deep as the literal)
+    const std::string text(20000, 'a');
+    DerivativeMatcher literal(toPostfix(preprocessRegex(text + "|b")));
+    CHECK(literal.matches(text) && literal.matches("b") && !literal.matches(text + "a"));
+    CHECK(literal.termCount() < 3 * 20000);
+}
+
+static void testStringGenerator() {
+    // Every in-alphabet edit of a 150-byte read is still accepted: only outside bytes reject
+    StringGenerator reads(compile("[ACGT]{50,500}"), 150);
+    std::string miss;
+    int misses = 0;
+    for (int i = 0; i < 50; i++) {
+        if (!reads.nearMiss(150, miss)) continue;
+        misses++;
+        CHECK(miss.size() >= 150 && miss.size() <= 151 && miss.find_first_not_of("ACGT") != std::string::npos);
+    }
+    CHECK(misses == 50);
+
+    // (AG)+ is rejected by in-alphabet edits too: both halves of the distribution show up
+    DFA pairs = compile("(AG)+");
+    StringGenerator generator(pairs, 8);
+    int inside = 0, outside = 0;
+    for (int i = 0; i < 200; i++) {
+        if (!generator.nearMiss(8, miss)) continue;
+        CHECK(!pairs.matches(miss) && miss.size() >= 7 && miss.size() <= 9);
+        (miss.find_first_not_of("AG") == std::string::npos ? inside : outside)++;
+    }
+    CHECK(inside > 20 && outside > 20);
+}
+
+static void testLexerAndPipeline() {
+    Lexer lexer({{"KEYWORD", "if|while"}, {"IDENT", "[a-z][a-z0-9]*"},
+                 {"NUMBER", "[0-9]+"}, {"SPACE", " +", true}});
+    std::vector<Token> tokens;
+    lexer.tokenize("while x1 iffy 42", tokens);
+    std::vector<std::string> names;
+    for (const auto& t : tokens) {
+        if (!lexer.isSkipped(t.id)) names.push_back(lexer.tokenName(t.id));
+    }
+    CHECK((names == std::vector<std::string>{"KEYWORD", "IDENT", "IDENT", "NUMBER"}));
+
+    tokens.clear();
+    lexer.tokenize("abcdefghijklmnopqrstuvwxyz0123456789 while", tokens);
+    CHECK(tokens.size() == 3 && tokens[0].length == 36 && lexer.tokenName(tokens[2].id) == "KEYWORD");
+
+    Lexer dna({{"A", "A"}, {"G", "G"}, {"C", "C"}, {"T", "T"}, {"U", "U"},
+               {".", "\\."}, {"SPACE", "\\s+", true}});
+    AdaptivePDA threaded, batched;
+    PipelineResult a = runPipeline(dna, "GGA.TCC", threaded);
+    PipelineResult b = runPipeline(dna, "GG A . T CC", batched, PipelineMode::BATCHED);
+    CHECK(a.accepted && a.tokenCount == 7);
+    CHECK(b.accepted && b.tokenCount == 7);
+
+    // The parse fails on the first token: the lexer stops at the closed ring, not at the end of input
+    // (at most a full ring of 4096 plus the batch being parsed)
+    const std::string junk(1 << 20, 'T');
+    PipelineResult c = runPipeline(dna, junk, threaded);
+    PipelineResult d = runPipeline(dna, junk, batched, PipelineMode::BATCHED);
+    CHECK(!c.accepted && c.tokenCount <= 4096 + 256);
+    CHECK(!d.accepted && d.tokenCount <= 256);
+    StateManager::clear();
+}
+
+static void testPlanner() {
+    PatternMatcher literal("GATTACA");
+    CHECK(literal.plan().engine == MatchEngine::LITERAL);
+    CHECK(literal.matches("GATTACA") && !literal.matches("GATTAC") && !literal.matches("GATTACAT"));
+
+    CHECK(PatternMatcher("[ACGT]+").plan().engine == MatchEngine::SHENG);
+    PatternMatcher ident("[a-zA-Z][a-zA-Z0-9]*");
+    CHECK(ident.plan().engine == (DFAJit::available() ? MatchEngine::JIT : MatchEngine::TABLE));
+    std::vector<char> results;
+    ident.matchAll({"x1", "1x", "", "abc"}, results);
+    CHECK((results == std::vector<char>{1, 0, 0, 1}));
+
+    // 2^21 DFA states: over the limit, simulated with a counting set instead
+    PatternMatcher wide("[ab]*a[ab]{20}");
+    CHECK(wide.plan().engine == MatchEngine::COUNTING);
+    CHECK(wide.plan().describe().find("DFA over") != std::string::npos);
+    CHECK(wide.matches("b" + std::string(21, 'a')) && !wide.matches("a" + std::string(20, 'b') + "b"));
+    wide.matchAll({std::string(21, 'a'), "ab"}, results);
+    CHECK((results == std::vector<char>{1, 0}));
+
+    CHECK(wide.plan().describe().find("requires 'a', scanned") != std::string::npos);
+
+    PatternAnalysis motif = analyzePattern(toPostfix(preprocessRegex("[ACGT]*TATA[AT]A[AT][ACGT]*")));
+    CHECK(motif.minLength == 7 && motif.maxLength == PatternAnalysis::UNBOUNDED);
+    CHECK(motif.firstBytes.count() == 4 && motif.requiredBytes.count() == 2 && motif.requiredBytes.test('T'));
+    CHECK(!motif.mayMatch("GGGGGGG", 7) && !motif.mayMatch("xTATAAAA", 8) && motif.mayMatch("TATAAAA", 7));
+    PatternAnalysis bounded = analyzePattern(toPostfix(preprocessRegex("(ab|c){2,3}d?")));
+    CHECK(bounded.minLength == 2 && bounded.maxLength == 7 && bounded.requiredBytes.none());
+    CHECK(!bounded.mayMatch("abababab", 8) && !bounded.mayMatch("d", 1));
+    PatternAnalysis accented = analyzePattern(toPostfix(preprocessRegex("é[α-ω]")), true);
+    CHECK(accented.minLength == 4 && accented.maxLength == 4 && accented.firstBytes.count() == 1);
+    CHECK(accented.requiredBytes.test(0xC3) && accented.requiredBytes.test(0xA9));
+
+    PatternMatcher once("a{1000}b|c", MatchWorkload::ONE_SHOT);
+    CHECK(once.plan().engine == MatchEngine::DERIVATIVE && once.matches("c"));
+
+    // Inputs that visit too many derivative states: the same matcher falls back to simulation
+    PatternMatcher window("(a|b)*a(a|b){20}", MatchWorkload::ONE_SHOT);
+    std::string random;
+    for (uint32_t x = 1; random.size() < 20000; x = x * 1103515245u + 12345u) random += (x >> 16 & 1) ? 'a' : 'b';
+    bool expected = random[random.size() - 21] == 'a';
+    CHECK(window.matches(random) == expected && window.plan().engine == MatchEngine::NFA);
+    CHECK(window.plan().describe().find("derivative states over") != std::string::npos);
+    CHECK(window.matches(std::string(21, 'a')) && !window.matches(std::string(21, 'b')));
+    PatternMatcher tiny("[a-z]{2,8}@[a-z]+", MatchWorkload::ONE_SHOT, false, 3);
+    CHECK(tiny.matches("user@host") && tiny.plan().engine == MatchEngine::COUNTING && !tiny.matches("u@host"));
+
+    // Long chains of optional terms go straight to simulation
+    std::string optional;
+    for (int i = 0; i < 1000; i++) optional += "a?";
+    PatternMatcher chain(optional + "b", MatchWorkload::ONE_SHOT);
+    CHECK(chain.plan().engine != MatchEngine::DERIVATIVE);
+    CHECK(chain.matches(std::string(1000, 'a') + "b") && !chain.matches(std::string(1001, 'a') + "b"));
+    PatternMatcher greek("[α-ω]+", MatchWorkload::ONE_SHOT, true);
+    CHECK(greek.plan().engine != MatchEngine::DERIVATIVE && greek.matches("λογ") && !greek.matches("λόγ"));
+
+    bool threw = false;
+    try {
+        PatternMatcher malformed("a|");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    StateManager::clear();
+}
+
+static void testBatchDedup() {
+    CHECK(hashBytes("", 0) == 0xEF46DB3751D8E999ULL);
+    CHECK(hashBytes("abc", 3) == 0x44BC2CF5AD770999ULL);
+    CHECK(hashBytes("Nobody inspects the spammish repetition", 39) == 0xFBCEA83C8A378BF1ULL);
+
+    std::vector<std::string> inputs = {"GATC", "", "GATC", "AAGCTT", "", "GATC"};
+    BatchDedup unique;
+    unique.build(inputs);
+    CHECK((unique.distinct() == std::vector<uint32_t>{0, 1, 3}));
+    CHECK(unique.slotOf(2) == 0 && unique.slotOf(4) == 1 && unique.slotOf(5) == 0);
+
+    PatternMatcher matcher("(GA|AA)[ACGT]*");
+    std::vector<char> plain, deduped;
+    matcher.matchAll(inputs, plain);
+    matcher.matchAll(inputs, deduped, true);
+    CHECK(plain == deduped && (plain == std::vector<char>{1, 0, 1, 1, 0, 1}));
+
+    AdaptivePDA parser;
+    std::vector<std::string> hairpins = {"GA.TC", "GG.C", "GA.TC", "AG.CU", "GG.C", "GA.TC"};
+    parser.parseAll(hairpins, plain);
+    parser.parseAll(hairpins, deduped, true);
+    CHECK(plain == deduped && plain[0] && !plain[1] && plain[3]);
+    StateManager::clear();
+}
+
+int main() {
+    testEngines();
+    testActiveStates();
+    testUtf8AndOperations();
+    testCompiledLayouts();
+    testHotDFA();
+    testDerivativeMatcher();
+    testStringGenerator();
+    testLexerAndPipeline();
+    testPlanner();
+    testBatchDedup();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -1,5 +1,9 @@
 #include "thompsons_construction.h"
+#include "regex_preprocessor.h"
 #include <stack>
+#include <map>
+#include <set>
+#include <tuple>
 #include <cctype>
 #include <iostream>
 
@@ -9,15 +13,32 @@
  * PROCESS:
  *   Each helper function creates NFA fragments by:
  *   - Allocating new start/end states via StateManager
- *   - Creating epsilon (E) or character transitions
+ *   - Creating epsilon or character transitions
  *   - Returning fragment with start and final state list
  *
- *   regexToNFA processes postfix expression using stack:
- *   - Push character fragments
- *   - Pop operands and apply operators
+ *   utf8Sequences(lo, hi) (as in RE2 / Rust regex-syntax):
+ *   - Drop the surrogate block, split at the 1/2/3/4-byte boundaries
+ *   - Split again until, for every continuation position, the range either
+ *     covers all 64 values or shares the byte prefix; then each byte position
+ *     is an independent [lo_k, hi_k] range
+ *
+ *   regexToNFA processes postfix expression token by token using stack:
+ *   - Push literal / escaped literal / character class fragments
+ *   - Pop operands and apply operators (. | * + {n,m})
  *   - Final stack must contain exactly 1 item
  */
 
+// Orders the two ε-edges of a quantifier: greedy prefers repeating, lazy prefers leaving
+static void addChoice(NFAState* from, NFAState* repeat, NFAState* leave, bool lazy) {
+    if (lazy) {
+        from->epsilon.push_back(leave);
+        from->epsilon.push_back(repeat);
+    } else {
+        from->epsilon.push_back(repeat);
+        from->epsilon.push_back(leave);
+    }
+}
+
 NFAFragment makeChar(char c) {
     NFAState* start = StateManager::create();
     NFAState* end = StateManager::create();
@@ -25,82 +46,264 @@ NFAFragment makeChar(char c) {
     return {start, {end}};
 }
 
+NFAFragment makeClass(const std::bitset<256>& bytes) {
+    NFAState* start = StateManager::create();
+    NFAState* end = StateManager::create();
+    for (int b = 0; b < 256; b++) {
+        if (bytes.test(b)) start->transitions[static_cast<char>(b)].push_back(end);
+    }
+    return {start, {end}};
+}
+
+struct ByteRange {
+    int lo;
+    int hi;
+};
+
+// Splits [lo, hi] into UTF-8 byte-range sequences, in ascending order
+static std::vector<std::vector<ByteRange>> utf8Sequences(int lo, int hi) {
+    static const int LENGTH_LIMITS[] = {0x7F, 0x7FF, 0xFFFF};
+    std::vector<std::vector<ByteRange>> sequences;
+    std::vector<CodePointRange> work = {{lo, hi}};
+
+    while (!work.empty()) {
+        CodePointRange r = work.back(); work.pop_back();
+        if (r.lo > r.hi) continue;
+
+        if (r.lo <= 0xDFFF && r.hi >= 0xD800) {
+            work.push_back({0xE000, r.hi});
+            work.push_back({r.lo, 0xD7FF});
+            continue;
+        }
+
+        bool split = false;
+        for (int limit : LENGTH_LIMITS) {
+            if (r.lo <= limit && limit < r.hi) {
+                work.push_back({limit + 1, r.hi});
+                work.push_back({r.lo, limit});
+                split = true;
+                break;
+            }
+        }
+        for (int k = 1; k < 4 && !split; k++) {
+            int mask = (1 << (6 * k)) - 1;
+            if ((r.lo & ~mask) == (r.hi & ~mask)) continue;
+            if ((r.lo & mask) != 0) {
+                work.push_back({(r.lo | mask) + 1, r.hi});
+                work.push_back({r.lo, r.lo | mask});
+                split = true;
+            } else if ((r.hi & mask) != mask) {
+                work.push_back({r.hi & ~mask, r.hi});
+                work.push_back({r.lo, (r.hi & ~mask) - 1});
+                split = true;
+            }
+        }
+        if (split) continue;
+
+        int low[4], high[4], length, highLength;
+        encodeUtf8(r.lo, low, length);
+        encodeUtf8(r.hi, high, highLength);
+        std::vector<ByteRange> sequence;
+        for (int k = 0; k < length; k++) sequence.push_back({low[k], high[k]});
+        sequences.push_back(sequence);
+    }
+    return sequences;
+}
+
+NFAFragment makeCodePointClass(const std::vector<CodePointRange>& ranges) {
+    NFAState* start = StateManager::create();
+    NFAState* end = StateManager::create();
+
+    // (byte range, target) -> state matching that range; shared by every sequence with that suffix
+    std::map<std::tuple<int, int, NFAState*>, NFAState*> suffixes;
+    std::set<std::tuple<int, int, NFAState*>> leads;
+
+    for (const auto& range : ranges) {
+        for (const auto& sequence : utf8Sequences(range.lo, range.hi)) {
+            NFAState* next = end;
+            for (size_t k = sequence.size() - 1; k > 0; k--) {
+                NFAState*& node = suffixes[std::make_tuple(sequence[k].lo, sequence[k].hi, next)];
+                if (!node) {
+                    node = StateManager::create();
+                    for (int b = sequence[k].lo; b <= sequence[k].hi; b++) {
+                        node->transitions[static_cast<char>(b)].push_back(next);
+                    }
+                }
+                next = node;
+            }
+
+            if (!leads.insert(std::make_tuple(sequence[0].lo, sequence[0].hi, next)).second) continue;
+            for (int b = sequence[0].lo; b <= sequence[0].hi; b++) {
+                start->transitions[static_cast<char>(b)].push_back(next);
+            }
+        }
+    }
+    return {start, {end}};
+}
+
+NFAFragment makeEmpty() {
+    NFAState* state = StateManager::create();
+    return {state, {state}};
+}
+
 NFAFragment makeUnion(NFAFragment first, NFAFragment second) {
     NFAState* start = StateManager::create();
     NFAState* end = StateManager::create();
-   
-    start->transitions['E'].push_back(first.start);
-    start->transitions['E'].push_back(second.start);
 
-    for (auto f : first.finals) f->transitions['E'].push_back(end);
-    for (auto f : second.finals) f->transitions['E'].push_back(end);
+    start->epsilon.push_back(first.start);
+    start->epsilon.push_back(second.start);
+
+    for (auto f : first.finals) f->epsilon.push_back(end);
+    for (auto f : second.finals) f->epsilon.push_back(end);
 
     return {start, {end}};
 }
 
 NFAFragment makeConcat(NFAFragment first, NFAFragment second) {
     for (auto f : first.finals) {
-        f->transitions['E'].push_back(second.start);
+        f->epsilon.push_back(second.start);
     }
     return {first.start, second.finals};
 }
 
-NFAFragment makeStar(NFAFragment fragment) {
+NFAFragment makeStar(NFAFragment fragment, bool lazy) {
     NFAState* start = StateManager::create();
     NFAState* end = StateManager::create();
 
-    start->transitions['E'].push_back(fragment.start);
-    start->transitions['E'].push_back(end);
+    addChoice(start, fragment.start, end, lazy);
 
     for (auto f : fragment.finals) {
-        f->transitions['E'].push_back(fragment.start);
-        f->transitions['E'].push_back(end);
+        addChoice(f, fragment.start, end, lazy);
     }
 
     return {start, {end}};
 }
 
-NFAFragment regexToNFA(std::string postfix) {
+NFAFragment makePlus(NFAFragment fragment, bool lazy) {
+    NFAState* end = StateManager::create();
+
+    for (auto f : fragment.finals) {
+        addChoice(f, fragment.start, end, lazy);
+    }
+
+    return {fragment.start, {end}};
+}
+
+NFAFragment makeOptional(NFAFragment fragment, bool lazy) {
+    NFAState* start = StateManager::create();
+    NFAState* end = StateManager::create();
+
+    addChoice(start, fragment.start, end, lazy);
+
+    for (auto f : fragment.finals) f->epsilon.push_back(end);
+
+    return {start, {end}};
+}
+
+NFAFragment makeRepeat(NFAFragment fragment, int min, int max, bool lazy) {
+    if (max == 0) return makeEmpty();
+    if (min == 1 && max == 1) return fragment;
+    if (min == 0 && max == 1) return makeOptional(fragment, lazy);
+    if (min == 0 && max < 0) return makeStar(fragment, lazy);
+    if (min == 1 && max < 0) return makePlus(fragment, lazy);
+
+    NFAState* start = StateManager::create();
+    NFAState* check = StateManager::create();
+    NFAState* end = StateManager::create();
+
+    check->counter = StateManager::createCounter({min, max, lazy, start, fragment.start, end});
+
+    if (min == 0) addChoice(start, fragment.start, end, lazy);
+    else start->epsilon.push_back(fragment.start);
+
+    for (auto f : fragment.finals) f->epsilon.push_back(check);
+
+    return {start, {end}};
+}
+
+NFAFragment regexToNFA(std::string postfix, bool utf8) {
     std::stack<NFAFragment> st;
-    for (char c : postfix) {
+    for (size_t i = 0; i < postfix.length(); ) {
+        size_t end = regexTokenEnd(postfix, i);
+        std::string token = postfix.substr(i, end - i);
+        char c = postfix[i];
+        bool lazy = (token.length() > 1 && token.back() == '?');
+        i = end;
+
         if (c == '.') {
-            if (st.size() < 2) { 
-                std::cerr << "Error: Malformed Regex (Stack Underflow on .)" << std::endl; 
-                exit(1); 
+            if (st.size() < 2) {
+                std::cerr << "Error: Malformed Regex (Stack Underflow on .)" << std::endl;
+                exit(1);
             }
             NFAFragment b = st.top(); st.pop();
             NFAFragment a = st.top(); st.pop();
             st.push(makeConcat(a, b));
         } else if (c == '|') {
-            if (st.size() < 2) { 
-                std::cerr << "Error: Malformed Regex (Stack Underflow on |)" << std::endl; 
-                exit(1); 
+            if (st.size() < 2) {
+                std::cerr << "Error: Malformed Regex (Stack Underflow on |)" << std::endl;
+                exit(1);
             }
             NFAFragment b = st.top(); st.pop();
             NFAFragment a = st.top(); st.pop();
             st.push(makeUnion(a, b));
-        } else if (c == '*') {
-            if (st.empty()) { 
-                std::cerr << "Error: Malformed Regex (Stack Underflow on *)" << std::endl; 
-                exit(1); 
+        } else if (c == '*' || c == '+') {
+            if (st.empty()) {
+                std::cerr << "Error: Malformed Regex (Stack Underflow on " << c << ")" << std::endl;
+                exit(1);
+            }
+            NFAFragment a = st.top(); st.pop();
+            st.push(c == '*' ? makeStar(a, lazy) : makePlus(a, lazy));
+        } else if (c == '{') {
+            int min, max;
+            if (st.empty() || !parseRepeat(token, min, max)) {
+                std::cerr << "Error: Malformed Regex (Invalid repetition " << token << ")" << std::endl;
+                exit(1);
             }
             NFAFragment a = st.top(); st.pop();
-            st.push(makeStar(a));
+            st.push(makeRepeat(a, min, max, lazy));
+        } else if (c == '[') {
+            if (utf8) st.push(makeCodePointClass(parseCodePointClass(token)));
+            else st.push(makeClass(parseCharacterClass(token)));
+        } else if (c == '\\' && token.length() == 2) {
+            st.push(makeChar(token[1]));
         } else {
             // Treat any other character as a literal operand
             st.push(makeChar(c));
         }
     }
-    if (st.empty()) { 
-        std::cerr << "Error: Empty Regex" << std::endl; 
-        exit(1); 
+    if (st.empty()) {
+        std::cerr << "Error: Empty Regex" << std::endl;
+        exit(1);
     }
-   
+
     if (st.size() != 1) {
-        std::cerr << "Error: NFA Construction failed. Stack size: " << st.size() 
+        std::cerr << "Error: NFA Construction failed. Stack size: " << st.size()
                   << " (Missing concatenation?)" << std::endl;
         exit(1);
     }
-   
+
     return st.top();
 }
+
+bool isValidPostfix(const std::string& postfix) {
+    size_t depth = 0;
+    for (size_t i = 0; i < postfix.length(); ) {
+        size_t end = regexTokenEnd(postfix, i);
+        std::string token = postfix.substr(i, end - i);
+        char c = postfix[i];
+        i = end;
+
+        if (c == '.' || c == '|') {
+            if (depth < 2) return false;
+            depth--;
+        } else if (c == '*' || c == '+') {
+            if (depth == 0) return false;
+        } else if (c == '{') {
+            int min, max;
+            if (depth == 0 || !parseRepeat(token, min, max)) return false;
+        } else {
+            depth++;
+        }
+    }
+    return depth == 1;
+}
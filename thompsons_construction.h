@@ -2,44 +2,83 @@
 #define THOMPSONS_CONSTRUCTION_H
 
 #include "nfa_state.h"
+#include "regex_preprocessor.h"
 #include <string>
+#include <bitset>
+#include <vector>
 
 /**
  * FILE: thompsons_construction.h
  * DESCRIPTION: Thompson's Construction algorithm - converts postfix regex to NFA
  * PROCESS:
  *   Thompson's Construction converts regular expressions to NFAs incrementally:
- *   
+ *
  *   1. makeChar(c) - Base case: Single character transition
  *      Creates: start -[c]-> end
  *
- *   2. makeConcat(A, B) - Concatenation operator (implicit in regex)
+ *   2. makeClass(bytes) - Character class / wildcard as ONE state pair
+ *      Creates: start -[b]-> end for every byte b in the set
+ *      [a-z] costs 2 states instead of a 26-way union (52+ states)
+ *
+ *   2b. makeCodePointClass(ranges) - Unicode class as a UTF-8 byte automaton
+ *      - Each code-point range is split into UTF-8 byte-range sequences,
+ *        e.g. U+0080..U+07FF -> [C2-DF][80-BF]
+ *      - Sequences are built back to front and identical suffixes
+ *        (byte range + target state) are shared, so '.' over all of Unicode
+ *        costs a dozen states; ASCII ranges stay single start -> end edges
+ *      - Matching still steps one byte at a time: no decoding at run time
+ *
+ *   3. makeConcat(A, B) - Concatenation operator (implicit in regex)
  *      Connects: A.end -[ε]-> B.start
  *      Result: A's final states point to B's start
  *
- *   3. makeUnion(A, B) - Alternation operator (|)
+ *   4. makeUnion(A, B) - Alternation operator (|)
  *      Creates new start/end states with epsilon transitions:
  *      - new_start -[ε]-> A.start
  *      - new_start -[ε]-> B.start
  *      - A.end -[ε]-> new_end
  *      - B.end -[ε]-> new_end
  *
- *   4. makeStar(A) - Kleene star operator (*)
+ *   5. makeStar(A) - Kleene star operator (*)
  *      Creates loops with epsilon transitions:
  *      - new_start -[ε]-> A.start
  *      - new_start -[ε]-> new_end
  *      - A.end -[ε]-> A.start (loop back)
  *      - A.end -[ε]-> new_end
  *
- *   5. regexToNFA(postfix) - Driver function
+ *   6. makePlus(A), makeOptional(A) - One-or-more (+) and zero-or-one (?)
+ *      Same shape as makeStar without the bypass / without the loop
+ *
+ *   7. makeRepeat(A, min, max) - Bounded repetition {n}, {n,}, {n,m}
+ *      - Trivial bounds reduce to ε / A / A? / A* / A+
+ *      - Otherwise: entry -[ε]-> A.start, A.end -[ε]-> check, where the check
+ *        state owns an NFACounter that loops back to A or leaves to exit
+ *      - State count is independent of the bounds (no textual copies)
+ *
+ *   Lazy quantifiers (*? +? {n,m}?) list the "leave" ε-edge before the
+ *   "repeat" ε-edge; engines that honour priority prefer shorter matches.
+ *
+ *   8. regexToNFA(postfix, utf8) - Driver function
  *      Uses stack to process postfix expression
  *      Validates stack operations
+ *      utf8 = true compiles classes and '.' over code points instead of bytes
+ *
+ *   9. isValidPostfix(postfix) - Same stack checks as regexToNFA without
+ *      building anything; callers with untrusted patterns check first, since
+ *      regexToNFA terminates the program on malformed input
  */
 
 NFAFragment makeChar(char c);
+NFAFragment makeClass(const std::bitset<256>& bytes);
+NFAFragment makeCodePointClass(const std::vector<CodePointRange>& ranges);
+NFAFragment makeEmpty();
 NFAFragment makeUnion(NFAFragment first, NFAFragment second);
 NFAFragment makeConcat(NFAFragment first, NFAFragment second);
-NFAFragment makeStar(NFAFragment fragment);
-NFAFragment regexToNFA(std::string postfix);
+NFAFragment makeStar(NFAFragment fragment, bool lazy = false);
+NFAFragment makePlus(NFAFragment fragment, bool lazy = false);
+NFAFragment makeOptional(NFAFragment fragment, bool lazy = false);
+NFAFragment makeRepeat(NFAFragment fragment, int min, int max, bool lazy = false);
+NFAFragment regexToNFA(std::string postfix, bool utf8 = false);
+bool isValidPostfix(const std::string& postfix);
 
 #endif
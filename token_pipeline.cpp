@@ -0,0 +1,162 @@
+#include "token_pipeline.h"
+#include "adaptive_pda.h"
+#include <algorithm>
+#include <thread>
+
+/**
+ * FILE: token_pipeline.cpp
+ * DESCRIPTION: Implementation of the lexer -> parser token pipeline
+ * PROCESS:
+ *
+ *   TokenRingBuffer:
+ *   - Capacity is rounded up to a power of two so wrap-around is a mask
+ *   - pushBatch(): copy as many tokens as fit, publish them with one
+ *     release-store of tail; yield while the ring is full, give up once
+ *     it is closed
+ *   - popBatch(): acquire tail, copy out up to max tokens, release head
+ *   - Either side may close(): the producer at end of input, the consumer
+ *     when the parse stops early (so a blocked producer can exit)
+ *
+ *   RingTokenSource::refill():
+ *   - popBatch() one batch, translate rule indices into the ID window
+ *
+ *   runPipeline():
+ *   - LexerProducer lexes up to one batch of non-skip tokens per call and
+ *     counts the tokens the ring accepted; it reports the end of input as
+ *     soon as the ring is closed
+ *   - THREADED: producer thread loops until input is exhausted, then closes
+ *   - BATCHED:  producer is installed as the ring's refill hook and runs on
+ *     the parser's thread whenever the ring runs dry
+ */
+
+static const size_t PRODUCER_BATCH = 256;
+
+TokenRingBuffer::TokenRingBuffer(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    slots.resize(size);
+    mask = size - 1;
+}
+
+size_t TokenRingBuffer::pushBatch(const Token* tokens, size_t count) {
+    size_t written = 0;
+    while (written < count) {
+        if (closed.load(std::memory_order_acquire)) return written;
+
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        size_t space = slots.size() - (t - h);
+        if (space == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        size_t n = std::min(space, count - written);
+        for (size_t i = 0; i < n; i++) slots[(t + i) & mask] = tokens[written + i];
+        tail.store(t + n, std::memory_order_release);
+        written += n;
+    }
+    return written;
+}
+
+size_t TokenRingBuffer::popBatch(Token* out, size_t max) {
+    for (;;) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (t != h) {
+            size_t n = std::min(t - h, max);
+            for (size_t i = 0; i < n; i++) out[i] = slots[(h + i) & mask];
+            head.store(h + n, std::memory_order_release);
+            return n;
+        }
+
+        if (closed.load(std::memory_order_acquire)) {
+            // Re-check: the producer may have published its last batch before closing
+            if (tail.load(std::memory_order_acquire) == h) return 0;
+            continue;
+        }
+
+        if (refill) {
+            if (!refill(*this)) close();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TokenRingBuffer::close() {
+    closed.store(true, std::memory_order_release);
+}
+
+RingTokenSource::RingTokenSource(TokenRingBuffer& ring, const std::vector<int>& ruleToSymbol,
+                                 int errorSymbol)
+    : ring(ring), ruleToSymbol(ruleToSymbol), errorSymbol(errorSymbol) {}
+
+bool RingTokenSource::refill() {
+    size_t n = ring.popBatch(batch, BATCH);
+    for (size_t i = 0; i < n; i++) {
+        int id = batch[i].id;
+        window[i] = (id == Lexer::ERROR_TOKEN) ? errorSymbol : ruleToSymbol[id];
+    }
+    cursor = window;
+    limit = window + n;
+    return n > 0;
+}
+
+struct LexerProducer {
+    const Lexer& lexer;
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+    size_t produced = 0;
+
+    LexerProducer(const Lexer& lexer, const char* data, size_t size)
+        : lexer(lexer), data(data), size(size) {}
+
+    // Lexes one batch into the ring; returns false once the input is exhausted or the ring closed
+    bool produce(TokenRingBuffer& ring) {
+        Token batch[PRODUCER_BATCH];
+        size_t limit = std::min(PRODUCER_BATCH, ring.capacity());
+        size_t n = 0;
+        Token token;
+        while (n < limit && lexer.next(data, size, pos, token)) {
+            if (lexer.isSkipped(token.id)) continue;
+            batch[n++] = token;
+        }
+        if (n > 0) produced += ring.pushBatch(batch, n);
+        return pos < size && !ring.isClosed();
+    }
+};
+
+PipelineResult runPipeline(const Lexer& lexer, const char* data, size_t size, AdaptivePDA& parser,
+                           PipelineMode mode, std::ostream* trace) {
+    std::vector<int> ruleToSymbol;
+    ruleToSymbol.reserve(lexer.ruleCount());
+    for (int id = 0; id < lexer.ruleCount(); id++) ruleToSymbol.push_back(parser.symbolId(lexer.tokenName(id)));
+    int errorSymbol = parser.symbolId(lexer.tokenName(Lexer::ERROR_TOKEN));
+
+    TokenRingBuffer ring;
+    RingTokenSource source(ring, ruleToSymbol, errorSymbol);
+    LexerProducer producer(lexer, data, size);
+    bool accepted;
+
+    if (mode == PipelineMode::THREADED) {
+        std::thread lexThread([&]() {
+            while (producer.produce(ring)) {}
+            ring.close();
+        });
+        accepted = parser.parse(source, trace);
+        ring.close();
+        lexThread.join();
+    } else {
+        ring.refill = [&](TokenRingBuffer& r) { return producer.produce(r); };
+        accepted = parser.parse(source, trace);
+    }
+
+    return {accepted, producer.produced};
+}
+
+PipelineResult runPipeline(const Lexer& lexer, const std::string& input, AdaptivePDA& parser,
+                           PipelineMode mode, std::ostream* trace) {
+    return runPipeline(lexer, input.data(), input.size(), parser, mode, trace);
+}
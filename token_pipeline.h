@@ -0,0 +1,92 @@
+#ifndef TOKEN_PIPELINE_H
+#define TOKEN_PIPELINE_H
+
+#include "lexer_generator.h"
+#include "token_source.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+class AdaptivePDA;
+
+/**
+ * FILE: token_pipeline.h
+ * DESCRIPTION: Lexer -> parser pipeline over a bounded token ring buffer
+ * PROCESS:
+ *
+ *   1. TokenRingBuffer: Bounded single-producer / single-consumer queue
+ *      - Fixed power-of-two capacity, allocated once
+ *      - head (consumer) and tail (producer) are monotonically increasing
+ *        atomic counters on separate cache lines; slot = counter & mask
+ *      - pushBatch()/popBatch() move whole batches so synchronization is paid
+ *        once per batch, not once per token
+ *      - close() marks the end of the stream; popBatch() returns 0 once the
+ *        buffer is closed and drained, pushBatch() stops pushing and returns
+ *        how many tokens it got in
+ *      - Optional refill hook: when the buffer is empty, the consumer calls the
+ *        hook itself instead of waiting (single-threaded batched mode)
+ *
+ *   2. RingTokenSource: TokenSource backend draining a TokenRingBuffer
+ *      - Pops a batch per refill and maps lexer rule indices to parser symbols
+ *
+ *   3. runPipeline(lexer, input, parser, mode)
+ *      - Producer: runs Lexer::next() over the input, drops skip tokens, and
+ *        pushes token batches into the ring; it stops lexing as soon as the
+ *        ring is closed, so a parse that fails early does not pay for the
+ *        rest of the input
+ *      - Consumer: AdaptivePDA::parse() pulls lookahead from a RingTokenSource
+ *      - THREADED: producer runs on its own thread, parser on the caller's
+ *      - BATCHED:  one thread; the parser lexes the next batch on demand
+ *      - The full token vector is never materialized: memory is bounded by
+ *        the ring capacity plus the parser stack
+ */
+
+class TokenRingBuffer {
+    std::vector<Token> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};  // Next slot to read
+    alignas(64) std::atomic<size_t> tail{0};  // Next slot to write
+    alignas(64) std::atomic<bool> closed{false};
+
+public:
+    std::function<bool(TokenRingBuffer&)> refill;  // Returns false when input is exhausted
+
+    explicit TokenRingBuffer(size_t capacity = 4096);
+
+    size_t pushBatch(const Token* tokens, size_t count);  // Tokens pushed (fewer once closed)
+    size_t popBatch(Token* out, size_t max);
+    void close();
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+    size_t capacity() const { return slots.size(); }
+};
+
+class RingTokenSource : public TokenSource {
+    static constexpr size_t BATCH = 256;
+
+    TokenRingBuffer& ring;
+    const std::vector<int>& ruleToSymbol;
+    int errorSymbol;
+    Token batch[BATCH];
+    int window[BATCH];
+
+protected:
+    bool refill() override;
+
+public:
+    RingTokenSource(TokenRingBuffer& ring, const std::vector<int>& ruleToSymbol, int errorSymbol);
+};
+
+enum class PipelineMode { THREADED, BATCHED };
+
+struct PipelineResult {
+    bool accepted;
+    size_t tokenCount;  // Tokens that reached the ring
+};
+
+PipelineResult runPipeline(const Lexer& lexer, const char* data, size_t size, AdaptivePDA& parser,
+                           PipelineMode mode = PipelineMode::THREADED, std::ostream* trace = nullptr);
+PipelineResult runPipeline(const Lexer& lexer, const std::string& input, AdaptivePDA& parser,
+                           PipelineMode mode = PipelineMode::THREADED, std::ostream* trace = nullptr);
+
+#endif
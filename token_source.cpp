@@ -0,0 +1,160 @@
+#include "token_source.h"
+#include <istream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * FILE: token_source.cpp
+ * DESCRIPTION: Implementation of the token source backends
+ * PROCESS:
+ *
+ *   SpanTokenSource::refill():
+ *   - First call exposes the whole caller array as the window; then end
+ *
+ *   ByteTokenSource::refill():
+ *   - Translate up to WINDOW bytes through the byte map into the window
+ *   - SKIP bytes are dropped; returns false once the bytes are exhausted
+ *
+ *   MappedFileTokenSource:
+ *   - Maps the file read-only (mmap on POSIX, MapViewOfFile on Windows)
+ *   - The OS pages the file in on demand; only the decode window is resident
+ *     in our own memory
+ *
+ *   StreamTokenSource::refill():
+ *   - Read the next chunk from the stream, then decode it like a byte source
+ *
+ *   LexerTokenSource::refill():
+ *   - Call Lexer::next() until the window is full or input ends
+ *   - Skip rules are dropped; the error token maps to errorSymbol
+ */
+
+// ---------------------------------------------------------------- Span
+
+SpanTokenSource::SpanTokenSource(const int* ids, size_t count) : data(ids), size(count) {}
+
+SpanTokenSource::SpanTokenSource(const std::vector<int>& ids) : data(ids.data()), size(ids.size()) {}
+
+bool SpanTokenSource::refill() {
+    if (consumed || size == 0) return false;
+    consumed = true;
+    cursor = data;
+    limit = data + size;
+    return true;
+}
+
+// ---------------------------------------------------------------- Bytes
+
+ByteTokenSource::ByteTokenSource(const char* data, size_t size, const ByteTokenMap& map)
+    : map(map), data(data), size(size) {}
+
+bool ByteTokenSource::refill() {
+    size_t n = 0;
+    while (pos < size && n < WINDOW) {
+        int id = map[static_cast<unsigned char>(data[pos++])];
+        if (id != SKIP) window[n++] = id;
+    }
+    cursor = window;
+    limit = window + n;
+    return n > 0;
+}
+
+// ---------------------------------------------------------------- Mapped file
+
+MappedFileTokenSource::MappedFileTokenSource(const std::string& path, const ByteTokenMap& map)
+    : ByteTokenSource(nullptr, 0, map) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path);
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+
+    if (mappedSize > 0) {
+        HANDLE view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (view) {
+            mapping = MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(view);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    mappedSize = static_cast<size_t>(st.st_size);
+
+    if (mappedSize > 0) {
+        void* addr = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            mapping = addr;
+            madvise(addr, mappedSize, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+#endif
+
+    if (mappedSize > 0 && !mapping) throw std::runtime_error("Cannot map " + path);
+    data = static_cast<const char*>(mapping);
+    size = mappedSize;
+}
+
+MappedFileTokenSource::~MappedFileTokenSource() {
+    if (!mapping) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mappedSize);
+#endif
+}
+
+// ---------------------------------------------------------------- Stream
+
+StreamTokenSource::StreamTokenSource(std::istream& in, const ByteTokenMap& map)
+    : ByteTokenSource(nullptr, 0, map), in(in) {}
+
+bool StreamTokenSource::refill() {
+    while (in) {
+        in.read(chunk, WINDOW);
+        data = chunk;
+        size = static_cast<size_t>(in.gcount());
+        pos = 0;
+        if (ByteTokenSource::refill()) return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------- Lexer
+
+LexerTokenSource::LexerTokenSource(const Lexer& lexer, const char* data, size_t size,
+                                   const std::vector<int>& ruleToSymbol, int errorSymbol)
+    : lexer(lexer), ruleToSymbol(ruleToSymbol), errorSymbol(errorSymbol), data(data), size(size) {}
+
+bool LexerTokenSource::refill() {
+    size_t n = 0;
+    Token token;
+    while (n < WINDOW && lexer.next(data, size, pos, token)) {
+        if (lexer.isSkipped(token.id)) continue;
+        window[n++] = (token.id == Lexer::ERROR_TOKEN) ? errorSymbol : ruleToSymbol[token.id];
+    }
+    cursor = window;
+    limit = window + n;
+    return n > 0;
+}
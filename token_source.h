@@ -0,0 +1,132 @@
+#ifndef TOKEN_SOURCE_H
+#define TOKEN_SOURCE_H
+
+#include "lexer_generator.h"
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * FILE: token_source.h
+ * DESCRIPTION: Pluggable pull interface feeding token IDs to AdaptivePDA
+ * PROCESS:
+ *
+ *   1. TokenSource: Base class with windowed zero-copy lookahead
+ *      - The source exposes a window [cursor, limit) of token IDs
+ *      - peek() / advance() are inline pointer operations on that window
+ *      - refill() (virtual) is only called when the window is used up,
+ *        so the virtual call is paid once per window, not once per token
+ *      - peek() returns END_OF_INPUT once refill() reports no more tokens
+ *      - IDs are the parser's symbol IDs (AdaptivePDA::symbolId)
+ *
+ *   2. Backends
+ *      - SpanTokenSource:       in-memory array of IDs; the window IS the
+ *                               caller's array (nothing copied)
+ *      - ByteTokenSource:       one token per input byte (DNA bases), bytes
+ *                               translated through a 256-entry map; SKIP
+ *                               bytes (whitespace) are dropped
+ *      - MappedFileTokenSource: ByteTokenSource over a memory-mapped file
+ *      - StreamTokenSource:     ByteTokenSource decoding fixed-size chunks
+ *                               read from a std::istream
+ *      - LexerTokenSource:      runs a generated Lexer window by window,
+ *                               mapping rule indices to parser symbols
+ *
+ *   3. Memory: every backend holds at most one fixed-size window, so a parse
+ *      needs O(window + parser stack depth) memory regardless of input size
+ */
+
+class TokenSource {
+protected:
+    const int* cursor = nullptr;
+    const int* limit = nullptr;
+
+    virtual bool refill() = 0;  // Point [cursor, limit) at the next non-empty window
+
+public:
+    static constexpr int END_OF_INPUT = -1;
+    static constexpr int SKIP = -2;
+    static constexpr size_t WINDOW = 4096;
+
+    virtual ~TokenSource() = default;
+
+    int peek() {
+        if (cursor == limit && !refill()) return END_OF_INPUT;
+        return *cursor;
+    }
+    void advance() {
+        if (cursor != limit) ++cursor;
+    }
+};
+
+typedef std::array<int, 256> ByteTokenMap;
+
+class SpanTokenSource : public TokenSource {
+    const int* data;
+    size_t size;
+    bool consumed = false;
+
+protected:
+    bool refill() override;
+
+public:
+    SpanTokenSource(const int* ids, size_t count);
+    explicit SpanTokenSource(const std::vector<int>& ids);
+};
+
+class ByteTokenSource : public TokenSource {
+    const ByteTokenMap& map;
+    int window[WINDOW];
+
+protected:
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+
+    bool refill() override;
+
+public:
+    ByteTokenSource(const char* data, size_t size, const ByteTokenMap& map);
+};
+
+class MappedFileTokenSource : public ByteTokenSource {
+    void* mapping = nullptr;
+    size_t mappedSize = 0;
+
+public:
+    MappedFileTokenSource(const std::string& path, const ByteTokenMap& map);
+    ~MappedFileTokenSource() override;
+    MappedFileTokenSource(const MappedFileTokenSource&) = delete;
+    MappedFileTokenSource& operator=(const MappedFileTokenSource&) = delete;
+};
+
+class StreamTokenSource : public ByteTokenSource {
+    std::istream& in;
+    char chunk[WINDOW];
+
+protected:
+    bool refill() override;
+
+public:
+    StreamTokenSource(std::istream& in, const ByteTokenMap& map);
+};
+
+class LexerTokenSource : public TokenSource {
+    const Lexer& lexer;
+    const std::vector<int>& ruleToSymbol;  // Lexer rule index -> parser symbol
+    int errorSymbol;
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+    int window[WINDOW];
+
+protected:
+    bool refill() override;
+
+public:
+    LexerTokenSource(const Lexer& lexer, const char* data, size_t size,
+                     const std::vector<int>& ruleToSymbol, int errorSymbol);
+};
+
+#endif